@@ -37,6 +37,14 @@ function(ecxx_target_compile_options target)
         list(APPEND options -flto)
     endif()
 
+    if (NATIVE)
+        list(APPEND options -march=native)
+    endif()
+
+    if (TRACE)
+        list(APPEND options -DECXX_TRACE)
+    endif()
+
     if (LOGIC_WARNINGS_INTO_ERRORS)
         list(APPEND options -Werror)
     endif()
@@ -16,7 +16,12 @@
 #ifndef ECXX_ALLOCATOR_HPP
 #define ECXX_ALLOCATOR_HPP
 
+#include "ecxx/span.hpp"
+
+#include <new>
 #include <cstdint>
+#include <utility>
+#include <type_traits>
 
 namespace ecxx {
 
@@ -38,18 +43,72 @@ public:
 
     virtual void deallocate(void* ptr) noexcept = 0;
 
+    /*
+     * Allocates up to count blocks of n bytes each into out. Returns number
+     * of allocated blocks, remaining entries of out are set to nullptr
+     */
+    virtual auto allocate_bulk(std::size_t n, std::size_t count,
+            Span<void*> out) noexcept -> std::size_t;
+
+    /*
+     * Deallocates all blocks from ptrs. Implementations may reorder ptrs,
+     * nullptr entries are ignored
+     */
+    virtual void deallocate_bulk(Span<void*> ptrs) noexcept;
+
     template<typename T = char>
     auto allocate(std::size_t n) noexcept -> T*;
 
     template<typename T = char>
     auto reallocate(void* ptr, std::size_t n) noexcept -> T*;
 
+    /*
+     * Allocates memory for single object and constructs it in place.
+     * Returns nullptr when allocation fails
+     */
+    template<typename T, typename... Args>
+    auto construct(Args&&... args) noexcept -> T*;
+
+    /*
+     * Destroys object and deallocates its memory. Object of polymorphic type
+     * may be passed by pointer to its base class that has virtual destructor
+     */
+    template<typename T>
+    void destroy(T* ptr) noexcept;
+
     virtual ~Allocator() noexcept;
 };
 
 inline
 Allocator::~Allocator() noexcept = default;
 
+inline auto
+Allocator::allocate_bulk(std::size_t n, std::size_t count,
+        Span<void*> out) noexcept -> std::size_t {
+    if (count > out.size()) {
+        count = out.size();
+    }
+
+    std::size_t allocated = 0;
+
+    while ((allocated < count) && ((out[allocated] = allocate(n)) != nullptr)) {
+        ++allocated;
+    }
+
+    for (auto i = allocated; i < out.size(); ++i) {
+        out[i] = nullptr;
+    }
+
+    return allocated;
+}
+
+inline void
+Allocator::deallocate_bulk(Span<void*> ptrs) noexcept {
+    for (auto ptr : ptrs) {
+        deallocate(ptr);
+    }
+}
+
 template<typename T> inline auto
 Allocator::allocate(std::size_t n) noexcept -> T* {
     return static_cast<T*>(allocate(n * sizeof(T)));
@@ -70,6 +129,35 @@ Allocator::reallocate(void*  ptr, std::size_t n) noexcept -> void* {
     return reallocate(ptr, n);
 }
 
+template<typename T, typename... Args> inline auto
+Allocator::construct(Args&&... args) noexcept -> T* {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+            "Over-aligned types are not supported");
+
+    void* memory = allocate(sizeof(T));
+
+    return (memory != nullptr) ?
+        ::new (memory) T(std::forward<Args>(args)...) : nullptr;
+}
+
+template<typename T> inline void
+Allocator::destroy(T* ptr) noexcept {
+    if (ptr != nullptr) {
+        const volatile void* memory;
+
+        /* Base subobject may not start at the beginning of allocation */
+        if constexpr (std::is_polymorphic<T>::value) {
+            memory = dynamic_cast<const volatile void*>(ptr);
+        }
+        else {
+            memory = ptr;
+        }
+
+        ptr->~T();
+        deallocate(const_cast<void*>(memory));
+    }
+}
+
 } /* namespace ecxx */
 
 #endif /* ECXX_ALLOCATOR_HPP */
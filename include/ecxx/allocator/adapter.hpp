@@ -0,0 +1,124 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_ALLOCATOR_ADAPTER_HPP
+#define ECXX_ALLOCATOR_ADAPTER_HPP
+
+#include "ecxx/allocator.hpp"
+
+#include <utility>
+#include <type_traits>
+
+namespace ecxx {
+namespace allocator {
+
+/* Detect native bulk operations of adapted allocator */
+template<typename T, typename = void>
+struct HasAllocateBulk : std::false_type { };
+
+template<typename T>
+struct HasAllocateBulk<T, std::void_t<decltype(std::declval<T&>().
+        allocate_bulk(std::size_t{}, std::size_t{},
+            std::declval<Span<void*>>()))>> : std::true_type { };
+
+template<typename T, typename = void>
+struct HasDeallocateBulk : std::false_type { };
+
+template<typename T>
+struct HasDeallocateBulk<T, std::void_t<decltype(std::declval<T&>().
+        deallocate_bulk(std::declval<Span<void*>>()))>> : std::true_type { };
+
+/*
+ * Exposes statically configured allocator like StaticPool or StaticSlab
+ * through Allocator interface. Bulk operations are forwarded to allocator
+ * when it provides them, otherwise Allocator defaults are used
+ */
+template<typename T>
+class Adapter final : public Allocator {
+public:
+    constexpr explicit Adapter(T& allocator) noexcept;
+
+    Adapter(Adapter&& other) noexcept = default;
+
+    Adapter(const Adapter& other) noexcept = default;
+
+    Adapter& operator=(Adapter&& other) noexcept = delete;
+
+    Adapter& operator=(const Adapter& other) noexcept = delete;
+
+    auto allocate(std::size_t n) noexcept -> void* override;
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* override;
+
+    void deallocate(void* ptr) noexcept override;
+
+    auto allocate_bulk(std::size_t n, std::size_t count,
+            Span<void*> out) noexcept -> std::size_t override;
+
+    void deallocate_bulk(Span<void*> ptrs) noexcept override;
+
+    ~Adapter() noexcept override;
+private:
+    T& m_allocator;
+};
+
+template<typename T> inline constexpr
+Adapter<T>::Adapter(T& allocator) noexcept :
+    m_allocator{allocator}
+{ }
+
+template<typename T> inline
+Adapter<T>::~Adapter() noexcept = default;
+
+template<typename T> inline auto
+Adapter<T>::allocate(std::size_t n) noexcept -> void* {
+    return m_allocator.allocate(n);
+}
+
+template<typename T> inline auto
+Adapter<T>::reallocate(void* ptr, std::size_t n) noexcept -> void* {
+    return m_allocator.reallocate(ptr, n);
+}
+
+template<typename T> inline void
+Adapter<T>::deallocate(void* ptr) noexcept {
+    m_allocator.deallocate(ptr);
+}
+
+template<typename T> inline auto
+Adapter<T>::allocate_bulk(std::size_t n, std::size_t count,
+        Span<void*> out) noexcept -> std::size_t {
+    if constexpr (HasAllocateBulk<T>::value) {
+        return m_allocator.allocate_bulk(n, count, out);
+    }
+    else {
+        return Allocator::allocate_bulk(n, count, out);
+    }
+}
+
+template<typename T> inline void
+Adapter<T>::deallocate_bulk(Span<void*> ptrs) noexcept {
+    if constexpr (HasDeallocateBulk<T>::value) {
+        m_allocator.deallocate_bulk(ptrs);
+    }
+    else {
+        Allocator::deallocate_bulk(ptrs);
+    }
+}
+
+} /* namespace allocator */
+} /* namespace ecxx */
+
+#endif /* ECXX_ALLOCATOR_ADAPTER_HPP */
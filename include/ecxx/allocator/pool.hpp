@@ -47,6 +47,18 @@ public:
 
     void deallocate(void* ptr) noexcept override;
 
+    /*
+     * Places all blocks during a single walk over allocated headers
+     */
+    auto allocate_bulk(std::size_t n, std::size_t count,
+            Span<void*> out) noexcept -> std::size_t override;
+
+    /*
+     * Sorts ptrs by address and releases them during a single walk over
+     * allocated headers
+     */
+    void deallocate_bulk(Span<void*> ptrs) noexcept override;
+
     ~Pool() noexcept override;
 private:
     std::uintptr_t m_memory_begin{0u};
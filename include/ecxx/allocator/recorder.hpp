@@ -0,0 +1,117 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_ALLOCATOR_RECORDER_HPP
+#define ECXX_ALLOCATOR_RECORDER_HPP
+
+#include "ecxx/span.hpp"
+#include "ecxx/allocator.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecxx {
+namespace allocator {
+
+/*
+ * Decorator that forwards to upstream allocator and records every event
+ * into buffer. With file, full buffer is appended to it, without file
+ * buffer works as a ring that overwrites the oldest events. Each block
+ * carries a hidden prefix with its lifetime id
+ */
+class Recorder final : public Allocator {
+public:
+    enum class Type : std::uint8_t {
+        ALLOCATE,
+        REALLOCATE,
+        DEALLOCATE
+    };
+
+    struct Event {
+        std::uint64_t timestamp;
+        std::uint64_t size;
+        std::uint32_t id;
+        std::uint16_t thread;
+        Type type;
+        std::uint8_t reserved;
+    };
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t event_size;
+    };
+
+    static constexpr char MAGIC[8]{'E', 'C', 'X', 'X', 'T', 'R', 'C', '\0'};
+
+    static constexpr std::uint32_t VERSION{1u};
+
+    Recorder(Allocator& upstream, Span<Event> buffer,
+            std::FILE* file = nullptr) noexcept;
+
+    Recorder(Recorder&& other) noexcept = delete;
+
+    Recorder(const Recorder& other) noexcept = delete;
+
+    Recorder& operator=(Recorder&& other) noexcept = delete;
+
+    Recorder& operator=(const Recorder& other) noexcept = delete;
+
+    auto allocate(std::size_t n) noexcept -> void* override;
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* override;
+
+    void deallocate(void* ptr) noexcept override;
+
+    /*
+     * Copies buffered events from the oldest one into out, recording may
+     * continue meanwhile. Return number of copied events
+     */
+    auto events(Span<Event> out) noexcept -> std::size_t;
+
+    /* Events overwritten in ring or not recorded for lack of buffer */
+    auto dropped() const noexcept -> std::uint64_t;
+
+    void flush() noexcept;
+
+    ~Recorder() noexcept override;
+private:
+    void record(Type type, std::uint32_t id, std::size_t size) noexcept;
+
+    void write() noexcept;
+
+    Allocator& m_upstream;
+    Span<Event> m_buffer;
+    std::FILE* m_file;
+    std::size_t m_head{0u};
+    std::size_t m_count{0u};
+    std::atomic<std::uint64_t> m_dropped{0u};
+    std::uint64_t m_start;
+    std::atomic<std::uint32_t> m_id{0u};
+    std::mutex m_mutex{};
+};
+
+inline auto
+Recorder::dropped() const noexcept -> std::uint64_t {
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+} /* namespace allocator */
+} /* namespace ecxx */
+
+#endif /* ECXX_ALLOCATOR_RECORDER_HPP */
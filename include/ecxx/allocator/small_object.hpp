@@ -0,0 +1,102 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_ALLOCATOR_SMALL_OBJECT_HPP
+#define ECXX_ALLOCATOR_SMALL_OBJECT_HPP
+
+#include "ecxx/span.hpp"
+#include "ecxx/allocator.hpp"
+
+#include <cstdint>
+
+namespace ecxx {
+namespace allocator {
+
+/*
+ * Requests up to MAX_SIZE bytes are rounded up to one of CLASSES size
+ * classes and served from runs of equal blocks. Runs are RUN_SIZE aligned
+ * and carved from memory, block finds its run by masking its address so
+ * there is no per-block header. Larger requests and requests that do not
+ * fit into memory anymore go to upstream
+ */
+class SmallObject final : public Allocator {
+public:
+    static constexpr std::size_t MAX_SIZE{1024u};
+
+    static constexpr std::size_t RUN_SIZE{16384u};
+
+    static constexpr std::size_t CLASSES{21u};
+
+    SmallObject(void* memory, std::size_t size, Allocator& upstream) noexcept;
+
+    template<typename T>
+    SmallObject(const Span<T>& memory, Allocator& upstream) noexcept;
+
+    SmallObject(SmallObject&& other) noexcept = delete;
+
+    SmallObject(const SmallObject& other) noexcept = delete;
+
+    SmallObject& operator=(SmallObject&& other) noexcept = delete;
+
+    SmallObject& operator=(const SmallObject& other) noexcept = delete;
+
+    auto allocate(std::size_t n) noexcept -> void* override;
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* override;
+
+    void deallocate(void* ptr) noexcept override;
+
+    /*
+     * Takes blocks from runs of a single size class
+     */
+    auto allocate_bulk(std::size_t n, std::size_t count,
+            Span<void*> out) noexcept -> std::size_t override;
+
+    void deallocate_bulk(Span<void*> ptrs) noexcept override;
+
+    ~SmallObject() noexcept override;
+private:
+    auto owns(const void* ptr) const noexcept -> bool;
+
+    auto run(std::size_t index) noexcept -> void*;
+
+    void release(void* ptr) noexcept;
+
+    Allocator& m_upstream;
+    std::uintptr_t m_memory_begin{0u};
+    std::uintptr_t m_memory_end{0u};
+    std::uintptr_t m_memory_next{0u};
+    void* m_runs_free{nullptr};
+    void* m_runs[CLASSES]{};
+};
+
+inline
+SmallObject::~SmallObject() noexcept = default;
+
+template<typename T> inline
+SmallObject::SmallObject(const Span<T>& memory, Allocator& upstream) noexcept :
+    SmallObject{memory.data(), memory.size_bytes(), upstream}
+{ }
+
+inline auto
+SmallObject::owns(const void* ptr) const noexcept -> bool {
+    return (std::uintptr_t(ptr) >= m_memory_begin) &&
+        (std::uintptr_t(ptr) < m_memory_end);
+}
+
+} /* namespace allocator */
+} /* namespace ecxx */
+
+#endif /* ECXX_ALLOCATOR_SMALL_OBJECT_HPP */
@@ -0,0 +1,212 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_ALLOCATOR_STATIC_POOL_HPP
+#define ECXX_ALLOCATOR_STATIC_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+namespace ecxx {
+namespace allocator {
+
+/*
+ * Pool with storage of Bytes owned as member array. Blocks are placed
+ * first-fit between address sorted headers. Headers hold offsets sized
+ * after Bytes, all links are offsets plus one so that empty pool is all
+ * zeros and can be placed in .bss or in a linker section without any
+ * runtime construction. Use Adapter to pass it as Allocator
+ */
+template<std::size_t Bytes, std::size_t Align = alignof(std::max_align_t)>
+class StaticPool {
+public:
+    static_assert((Align != 0) && ((Align & (Align - 1u)) == 0),
+            "Alignment must be a power of two");
+
+    using offset_type = std::conditional_t<(Bytes < 0xFFFFu), std::uint16_t,
+        std::conditional_t<(Bytes < 0xFFFFFFFFu), std::uint32_t,
+        std::uint64_t>>;
+
+    static constexpr std::size_t SIZE{Bytes};
+
+    static constexpr std::size_t ALIGN{Align};
+
+    constexpr StaticPool() noexcept = default;
+
+    StaticPool(StaticPool&& other) noexcept = delete;
+
+    StaticPool(const StaticPool& other) noexcept = delete;
+
+    StaticPool& operator=(StaticPool&& other) noexcept = delete;
+
+    StaticPool& operator=(const StaticPool& other) noexcept = delete;
+
+    auto allocate(std::size_t n) noexcept -> void*;
+
+    /* Pointer not owned by pool is left alone and nullptr is returned */
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void*;
+
+    void deallocate(void* ptr) noexcept;
+
+    auto owns(const void* ptr) const noexcept -> bool;
+private:
+    struct Header {
+        offset_type next;
+        offset_type size;
+    };
+
+    static constexpr std::size_t HEADER_ALIGN{
+        std::max(alignof(Header), Align)};
+
+    static constexpr std::size_t HEADER_OFFSET{HEADER_ALIGN - 1u};
+
+    static constexpr std::size_t HEADER_MASK{~HEADER_OFFSET};
+
+    static constexpr auto align(std::size_t offset) noexcept -> std::size_t;
+
+    auto header(std::size_t link) noexcept -> Header*;
+
+    alignas(HEADER_ALIGN) unsigned char m_storage[Bytes]{};
+    offset_type m_first{0u};
+};
+
+template<std::size_t Bytes, std::size_t Align> inline constexpr auto
+StaticPool<Bytes, Align>::align(std::size_t offset) noexcept -> std::size_t {
+    return (offset + sizeof(Header) + HEADER_OFFSET) & HEADER_MASK;
+}
+
+template<std::size_t Bytes, std::size_t Align> inline auto
+StaticPool<Bytes, Align>::header(std::size_t link) noexcept -> Header* {
+    return reinterpret_cast<Header*>(&m_storage[link - 1u]);
+}
+
+template<std::size_t Bytes, std::size_t Align> inline auto
+StaticPool<Bytes, Align>::owns(const void* ptr) const noexcept -> bool {
+    return (std::uintptr_t(ptr) > std::uintptr_t(m_storage)) &&
+        (std::uintptr_t(ptr) < std::uintptr_t(m_storage + Bytes));
+}
+
+template<std::size_t Bytes, std::size_t Align> inline auto
+StaticPool<Bytes, Align>::allocate(std::size_t n) noexcept -> void* {
+    void* ptr = nullptr;
+
+    if ((n != 0) && (n < Bytes)) {
+        std::size_t prev = 0;
+        std::size_t next = m_first;
+
+        /* Walk gaps between headers, link is offset plus one */
+        for (;;) {
+            const auto begin = align((prev != 0) ?
+                    ((prev - 1u) + sizeof(Header) + header(prev)->size) : 0u);
+            const auto end = (next != 0) ? (next - 1u) : Bytes;
+
+            if ((begin <= end) && (n <= (end - begin))) {
+                const auto link = begin - sizeof(Header) + 1u;
+                auto hdr = header(link);
+
+                hdr->next = offset_type(next);
+                hdr->size = offset_type(n);
+
+                if (prev != 0) {
+                    header(prev)->next = offset_type(link);
+                }
+                else {
+                    m_first = offset_type(link);
+                }
+
+                ptr = &m_storage[begin];
+                break;
+            }
+
+            if (next == 0) {
+                break;
+            }
+
+            prev = next;
+            next = header(next)->next;
+        }
+    }
+
+    return ptr;
+}
+
+template<std::size_t Bytes, std::size_t Align> inline auto
+StaticPool<Bytes, Align>::reallocate(void* ptr,
+        std::size_t n) noexcept -> void* {
+    void* result = nullptr;
+
+    if (ptr == nullptr) {
+        result = allocate(n);
+    }
+    else if (n == 0) {
+        deallocate(ptr);
+    }
+    else if (owns(ptr)) {
+        const auto offset = std::size_t(static_cast<unsigned char*>(ptr) -
+                m_storage);
+        auto hdr = header(offset - sizeof(Header) + 1u);
+        const auto end = (hdr->next != 0) ? (hdr->next - 1u) : Bytes;
+
+        if (n <= (end - offset)) {
+            hdr->size = offset_type(n);
+            result = ptr;
+        }
+        else {
+            result = allocate(n);
+
+            if (result != nullptr) {
+                std::memcpy(result, ptr, std::min<std::size_t>(hdr->size, n));
+                deallocate(ptr);
+            }
+        }
+    }
+
+    return result;
+}
+
+template<std::size_t Bytes, std::size_t Align> inline void
+StaticPool<Bytes, Align>::deallocate(void* ptr) noexcept {
+    if (owns(ptr)) {
+        const auto target = std::size_t(static_cast<unsigned char*>(ptr) -
+                m_storage) - sizeof(Header) + 1u;
+
+        std::size_t prev = 0;
+        std::size_t link = m_first;
+
+        while ((link != 0) && (link < target)) {
+            prev = link;
+            link = header(link)->next;
+        }
+
+        if (link == target) {
+            const auto next = header(link)->next;
+
+            if (prev != 0) {
+                header(prev)->next = next;
+            }
+            else {
+                m_first = next;
+            }
+        }
+    }
+}
+
+} /* namespace allocator */
+} /* namespace ecxx */
+
+#endif /* ECXX_ALLOCATOR_STATIC_POOL_HPP */
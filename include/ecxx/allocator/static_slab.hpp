@@ -0,0 +1,188 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_ALLOCATOR_STATIC_SLAB_HPP
+#define ECXX_ALLOCATOR_STATIC_SLAB_HPP
+
+#include "ecxx/span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+namespace ecxx {
+namespace allocator {
+
+/*
+ * Count blocks of BlockSize bytes owned as member array with bitmap of
+ * used blocks. Empty slab is all zeros and can be placed in .bss or in
+ * a linker section without any runtime construction. Use Adapter to pass
+ * it as Allocator
+ */
+template<std::size_t BlockSize, std::size_t Count>
+class StaticSlab {
+public:
+    static_assert((BlockSize != 0) && (Count != 0),
+            "Block size and count must not be zero");
+
+    static constexpr std::size_t BLOCK_SIZE{BlockSize};
+
+    static constexpr std::size_t COUNT{Count};
+
+    /* The largest power of two that divides block size */
+    static constexpr std::size_t BLOCK_ALIGN{std::min(
+        BlockSize & (~BlockSize + 1u), alignof(std::max_align_t))};
+
+    static constexpr std::size_t WORD_BITS{64u};
+
+    static constexpr std::size_t WORDS{(Count + WORD_BITS - 1u) / WORD_BITS};
+
+    constexpr StaticSlab() noexcept = default;
+
+    StaticSlab(StaticSlab&& other) noexcept = delete;
+
+    StaticSlab(const StaticSlab& other) noexcept = delete;
+
+    StaticSlab& operator=(StaticSlab&& other) noexcept = delete;
+
+    StaticSlab& operator=(const StaticSlab& other) noexcept = delete;
+
+    auto allocate(std::size_t n) noexcept -> void*;
+
+    /* Pointer not owned by slab is left alone and nullptr is returned */
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void*;
+
+    void deallocate(void* ptr) noexcept;
+
+    auto allocate_bulk(std::size_t n, std::size_t count,
+            Span<void*> out) noexcept -> std::size_t;
+
+    void deallocate_bulk(Span<void*> ptrs) noexcept;
+
+    auto owns(const void* ptr) const noexcept -> bool;
+private:
+    static constexpr std::uint64_t LAST_WORD_MASK{
+        ((Count % WORD_BITS) != 0) ?
+        ((std::uint64_t(1) << (Count % WORD_BITS)) - 1u) : ~std::uint64_t(0)};
+
+    auto take() noexcept -> void*;
+
+    alignas(BLOCK_ALIGN) unsigned char m_storage[BlockSize * Count]{};
+    std::uint64_t m_used[WORDS]{};
+    std::size_t m_hint{0u};
+};
+
+template<std::size_t BlockSize, std::size_t Count> inline auto
+StaticSlab<BlockSize, Count>::owns(const void* ptr) const noexcept -> bool {
+    return (std::uintptr_t(ptr) >= std::uintptr_t(m_storage)) &&
+        (std::uintptr_t(ptr) < std::uintptr_t(m_storage + sizeof(m_storage)));
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline auto
+StaticSlab<BlockSize, Count>::take() noexcept -> void* {
+    void* ptr = nullptr;
+
+    /* Start from the word that had the last free block */
+    for (std::size_t i = 0; i < WORDS; ++i) {
+        const auto index = (m_hint + i) % WORDS;
+        const auto mask = (index == (WORDS - 1u)) ? LAST_WORD_MASK :
+            ~std::uint64_t(0);
+        const auto free = ~m_used[index] & mask;
+
+        if (free != 0) {
+            const auto bit = std::size_t(__builtin_ctzll(free));
+
+            m_used[index] |= std::uint64_t(1) << bit;
+            m_hint = index;
+            ptr = &m_storage[((index * WORD_BITS) + bit) * BlockSize];
+            break;
+        }
+    }
+
+    return ptr;
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline auto
+StaticSlab<BlockSize, Count>::allocate(std::size_t n) noexcept -> void* {
+    return ((n != 0) && (n <= BlockSize)) ? take() : nullptr;
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline auto
+StaticSlab<BlockSize, Count>::reallocate(void* ptr,
+        std::size_t n) noexcept -> void* {
+    void* result = nullptr;
+
+    if (ptr == nullptr) {
+        result = allocate(n);
+    }
+    else if (n == 0) {
+        deallocate(ptr);
+    }
+    else if ((n <= BlockSize) && owns(ptr)) {
+        result = ptr;
+    }
+
+    return result;
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline void
+StaticSlab<BlockSize, Count>::deallocate(void* ptr) noexcept {
+    if (owns(ptr)) {
+        const auto block = std::size_t(static_cast<unsigned char*>(ptr) -
+                m_storage) / BlockSize;
+
+        m_used[block / WORD_BITS] &= ~(std::uint64_t(1) << (block % WORD_BITS));
+    }
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline auto
+StaticSlab<BlockSize, Count>::allocate_bulk(std::size_t n, std::size_t count,
+        Span<void*> out) noexcept -> std::size_t {
+    if (count > out.size()) {
+        count = out.size();
+    }
+
+    std::size_t allocated = 0;
+
+    if ((n != 0) && (n <= BlockSize)) {
+        while (allocated < count) {
+            auto ptr = take();
+
+            if (ptr == nullptr) {
+                break;
+            }
+
+            out[allocated++] = ptr;
+        }
+    }
+
+    for (auto i = allocated; i < out.size(); ++i) {
+        out[i] = nullptr;
+    }
+
+    return allocated;
+}
+
+template<std::size_t BlockSize, std::size_t Count> inline void
+StaticSlab<BlockSize, Count>::deallocate_bulk(Span<void*> ptrs) noexcept {
+    for (auto ptr : ptrs) {
+        deallocate(ptr);
+    }
+}
+
+} /* namespace allocator */
+} /* namespace ecxx */
+
+#endif /* ECXX_ALLOCATOR_STATIC_SLAB_HPP */
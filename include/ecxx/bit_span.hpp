@@ -0,0 +1,293 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_BIT_SPAN_HPP
+#define ECXX_BIT_SPAN_HPP
+
+#include "ecxx/span.hpp"
+
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecxx {
+
+/*
+ * View of bits stored in 64-bit words, bit n lives in word n / 64 at
+ * position n % 64. Only bits below size() are meaningful, bits above it in
+ * the last word may hold anything. Bulk operations use AVX2 when the
+ * library is built with it
+ */
+class BitSpan {
+public:
+    using word_type = std::uint64_t;
+
+    using size_type = std::size_t;
+
+    static constexpr size_type WORD_BITS{64u};
+
+    static constexpr size_type npos{std::numeric_limits<size_type>::max()};
+
+    constexpr BitSpan() noexcept = default;
+
+    constexpr BitSpan(Span<word_type> words) noexcept;
+
+    constexpr BitSpan(Span<word_type> words, size_type bits) noexcept;
+
+    constexpr auto size() const noexcept -> size_type;
+
+    constexpr auto words() const noexcept -> Span<word_type>;
+
+    auto test(size_type pos) const noexcept -> bool;
+
+    void set(size_type pos) noexcept;
+
+    void reset(size_type pos) noexcept;
+
+    void flip(size_type pos) noexcept;
+
+    void set(size_type first, size_type count) noexcept;
+
+    void reset(size_type first, size_type count) noexcept;
+
+    auto count() const noexcept -> size_type;
+
+    auto any() const noexcept -> bool;
+
+    auto none() const noexcept -> bool;
+
+    auto find_first_set(size_type pos = 0) const noexcept -> size_type;
+
+    auto find_first_clear(size_type pos = 0) const noexcept -> size_type;
+
+    /*
+     * Logic operations process bits below the smaller of both sizes, bits
+     * at or above it are left untouched
+     */
+    auto operator&=(const BitSpan& other) noexcept -> BitSpan&;
+
+    auto operator|=(const BitSpan& other) noexcept -> BitSpan&;
+
+    auto operator^=(const BitSpan& other) noexcept -> BitSpan&;
+
+    /* this = this & ~other */
+    auto andn(const BitSpan& other) noexcept -> BitSpan&;
+private:
+    Span<word_type> m_words{};
+    size_type m_size{0u};
+};
+
+/*
+ * Fixed size bitset with inline storage, all operations go through
+ * BitSpan. Zero initialized, so it can be placed in .bss
+ */
+template<std::size_t N>
+class Bitset {
+public:
+    static constexpr std::size_t WORDS{
+        (N + BitSpan::WORD_BITS - 1u) / BitSpan::WORD_BITS};
+
+    constexpr Bitset() noexcept = default;
+
+    constexpr auto size() const noexcept -> std::size_t;
+
+    auto span() noexcept -> BitSpan;
+
+    auto span() const noexcept -> BitSpan;
+
+    auto test(std::size_t pos) const noexcept -> bool;
+
+    auto set(std::size_t pos) noexcept -> Bitset&;
+
+    auto reset(std::size_t pos) noexcept -> Bitset&;
+
+    auto flip(std::size_t pos) noexcept -> Bitset&;
+
+    auto set(std::size_t first, std::size_t count) noexcept -> Bitset&;
+
+    auto reset(std::size_t first, std::size_t count) noexcept -> Bitset&;
+
+    auto count() const noexcept -> std::size_t;
+
+    auto any() const noexcept -> bool;
+
+    auto none() const noexcept -> bool;
+
+    auto find_first_set(std::size_t pos = 0) const noexcept -> std::size_t;
+
+    auto find_first_clear(std::size_t pos = 0) const noexcept -> std::size_t;
+
+    auto operator&=(const Bitset& other) noexcept -> Bitset&;
+
+    auto operator|=(const Bitset& other) noexcept -> Bitset&;
+
+    auto operator^=(const Bitset& other) noexcept -> Bitset&;
+
+    auto andn(const Bitset& other) noexcept -> Bitset&;
+private:
+    std::uint64_t m_words[WORDS]{};
+};
+
+inline constexpr
+BitSpan::BitSpan(Span<word_type> words) noexcept :
+    m_words{words},
+    m_size{words.size() * WORD_BITS}
+{ }
+
+inline constexpr
+BitSpan::BitSpan(Span<word_type> words, size_type bits) noexcept :
+    m_words{words},
+    m_size{(bits < (words.size() * WORD_BITS)) ?
+        bits : (words.size() * WORD_BITS)}
+{ }
+
+inline constexpr auto
+BitSpan::size() const noexcept -> size_type {
+    return m_size;
+}
+
+inline constexpr auto
+BitSpan::words() const noexcept -> Span<word_type> {
+    return m_words;
+}
+
+inline auto
+BitSpan::test(size_type pos) const noexcept -> bool {
+    return ((m_words[pos / WORD_BITS] >> (pos % WORD_BITS)) & 1u) != 0;
+}
+
+inline void
+BitSpan::set(size_type pos) noexcept {
+    m_words[pos / WORD_BITS] |= word_type(1) << (pos % WORD_BITS);
+}
+
+inline void
+BitSpan::reset(size_type pos) noexcept {
+    m_words[pos / WORD_BITS] &= ~(word_type(1) << (pos % WORD_BITS));
+}
+
+inline void
+BitSpan::flip(size_type pos) noexcept {
+    m_words[pos / WORD_BITS] ^= word_type(1) << (pos % WORD_BITS);
+}
+
+inline auto
+BitSpan::none() const noexcept -> bool {
+    return !any();
+}
+
+template<std::size_t N> inline constexpr auto
+Bitset<N>::size() const noexcept -> std::size_t {
+    return N;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::span() noexcept -> BitSpan {
+    return {m_words, N};
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::span() const noexcept -> BitSpan {
+    /* BitSpan is a mutable view, const methods only read through it */
+    return {{const_cast<std::uint64_t*>(m_words), WORDS}, N};
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::test(std::size_t pos) const noexcept -> bool {
+    return span().test(pos);
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::set(std::size_t pos) noexcept -> Bitset& {
+    span().set(pos);
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::reset(std::size_t pos) noexcept -> Bitset& {
+    span().reset(pos);
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::flip(std::size_t pos) noexcept -> Bitset& {
+    span().flip(pos);
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::set(std::size_t first, std::size_t count) noexcept -> Bitset& {
+    span().set(first, count);
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::reset(std::size_t first, std::size_t count) noexcept -> Bitset& {
+    span().reset(first, count);
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::count() const noexcept -> std::size_t {
+    return span().count();
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::any() const noexcept -> bool {
+    return span().any();
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::none() const noexcept -> bool {
+    return span().none();
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::find_first_set(std::size_t pos) const noexcept -> std::size_t {
+    return span().find_first_set(pos);
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::find_first_clear(std::size_t pos) const noexcept -> std::size_t {
+    return span().find_first_clear(pos);
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::operator&=(const Bitset& other) noexcept -> Bitset& {
+    span() &= other.span();
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::operator|=(const Bitset& other) noexcept -> Bitset& {
+    span() |= other.span();
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::operator^=(const Bitset& other) noexcept -> Bitset& {
+    span() ^= other.span();
+    return *this;
+}
+
+template<std::size_t N> inline auto
+Bitset<N>::andn(const Bitset& other) noexcept -> Bitset& {
+    span().andn(other.span());
+    return *this;
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_BIT_SPAN_HPP */
@@ -0,0 +1,92 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_EXECUTOR_HPP
+#define ECXX_EXECUTOR_HPP
+
+#include "ecxx/allocator.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+
+namespace ecxx {
+
+/*
+ * Fixed pool of worker threads. Work is a range of chunk indices that is
+ * lazily split in halves and balanced between workers with Chase-Lev
+ * work-stealing deques. The thread that calls run() takes part as worker 0,
+ * only one thread at a time may call run() and calls cannot be nested.
+ */
+class Executor {
+public:
+    static constexpr std::size_t CACHE_LINE{64u};
+
+    using Function = void (*)(void* context, std::size_t worker,
+            std::size_t begin, std::size_t end) noexcept;
+
+    explicit Executor(Allocator& allocator, std::size_t workers = 0) noexcept;
+
+    Executor(Executor&& other) noexcept = delete;
+
+    Executor(const Executor& other) noexcept = delete;
+
+    Executor& operator=(Executor&& other) noexcept = delete;
+
+    Executor& operator=(const Executor& other) noexcept = delete;
+
+    auto workers() const noexcept -> std::size_t;
+
+    auto allocator() noexcept -> Allocator&;
+
+    void run(Function function, void* context, std::size_t chunks) noexcept;
+
+    ~Executor() noexcept;
+private:
+    struct Worker;
+
+    void work(std::size_t index) noexcept;
+
+    void wait(std::size_t index) noexcept;
+
+    Allocator& m_allocator;
+    void* m_memory{nullptr};
+    Worker* m_workers{nullptr};
+    std::size_t m_workers_count{1u};
+    Function m_function{nullptr};
+    void* m_context{nullptr};
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_pending{0u};
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_active{0u};
+    std::mutex m_mutex{};
+    std::condition_variable m_condition{};
+    std::uint64_t m_epoch{0u};
+    bool m_stop{false};
+};
+
+inline auto
+Executor::workers() const noexcept -> std::size_t {
+    return m_workers_count;
+}
+
+inline auto
+Executor::allocator() noexcept -> Allocator& {
+    return m_allocator;
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_EXECUTOR_HPP */
@@ -0,0 +1,541 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_INPLACE_FUNCTION_HPP
+#define ECXX_INPLACE_FUNCTION_HPP
+
+#include "ecxx/allocator.hpp"
+
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <exception>
+#include <type_traits>
+
+namespace ecxx {
+
+template<typename R, bool Noexcept, typename... Args>
+struct InplaceVTable {
+    using Invoke = R (*)(void* storage, Args&&... args) noexcept(Noexcept);
+
+    static auto empty() noexcept -> const InplaceVTable*;
+
+    Invoke invoke;
+    void (*move)(void* dst, void* src) noexcept;
+    bool (*copy)(void* dst, const void* src);
+    void (*destroy)(void* storage) noexcept;
+};
+
+/*
+ * Owns callable placed in buffer of Capacity bytes, copy operations are
+ * deleted when Copyable is false. Copy constructor and copy assignment
+ * terminate when copy of remote callable cannot be allocated, assign()
+ * reports it instead
+ */
+template<typename VTable, std::size_t Capacity, bool Copyable>
+class InplaceStorage;
+
+template<typename VTable, std::size_t Capacity>
+class InplaceStorage<VTable, Capacity, false> {
+public:
+    InplaceStorage() noexcept;
+
+    InplaceStorage(InplaceStorage&& other) noexcept;
+
+    InplaceStorage(const InplaceStorage& other) = delete;
+
+    InplaceStorage& operator=(InplaceStorage&& other) noexcept;
+
+    InplaceStorage& operator=(const InplaceStorage& other) = delete;
+
+    ~InplaceStorage() noexcept;
+protected:
+    alignas(std::max_align_t) unsigned char m_buffer[Capacity];
+    const VTable* m_vtable;
+};
+
+template<typename VTable, std::size_t Capacity>
+class InplaceStorage<VTable, Capacity, true> :
+        public InplaceStorage<VTable, Capacity, false> {
+public:
+    InplaceStorage() noexcept = default;
+
+    InplaceStorage(InplaceStorage&& other) noexcept = default;
+
+    InplaceStorage(const InplaceStorage& other);
+
+    InplaceStorage& operator=(InplaceStorage&& other) noexcept = default;
+
+    InplaceStorage& operator=(const InplaceStorage& other);
+
+    /* Return false and keep current callable when copy cannot be allocated */
+    auto assign(const InplaceStorage& other) -> bool;
+
+    ~InplaceStorage() noexcept = default;
+};
+
+struct InplaceFunctionTag { };
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+class InplaceFunctionBase : public InplaceFunctionTag {
+public:
+    using result_type = R;
+
+    static constexpr std::size_t CAPACITY{Capacity};
+
+    static constexpr std::size_t ALIGN{alignof(std::max_align_t)};
+
+    template<typename T>
+    static constexpr auto fits() noexcept -> bool;
+
+    InplaceFunctionBase() noexcept = default;
+
+    InplaceFunctionBase(std::nullptr_t) noexcept;
+
+    /*
+     * Callable must fit into inline buffer, it is checked at compile time
+     */
+    template<typename F, typename = std::enable_if_t<!std::is_base_of<
+        InplaceFunctionTag, std::decay_t<F>>::value>>
+    InplaceFunctionBase(F&& function) noexcept;
+
+    /*
+     * Callable that does not fit into inline buffer is placed in memory from
+     * allocator, function stays empty when allocation fails. Copies allocate
+     * from the same allocator, use assign() when their failure must be
+     * handled, copy constructor and copy assignment terminate on it
+     */
+    template<typename F>
+    InplaceFunctionBase(Allocator& allocator, F&& function) noexcept;
+
+    InplaceFunctionBase(InplaceFunctionBase&& other) noexcept = default;
+
+    InplaceFunctionBase(const InplaceFunctionBase& other) = default;
+
+    InplaceFunctionBase& operator=(
+            InplaceFunctionBase&& other) noexcept = default;
+
+    InplaceFunctionBase& operator=(const InplaceFunctionBase& other) = default;
+
+    InplaceFunctionBase& operator=(std::nullptr_t) noexcept;
+
+    /*
+     * Copies other, return false and keep current callable when copy of
+     * remote callable cannot be allocated
+     */
+    auto assign(const InplaceFunctionBase& other) -> bool;
+
+    template<typename F, typename = std::enable_if_t<!std::is_base_of<
+        InplaceFunctionTag, std::decay_t<F>>::value>>
+    InplaceFunctionBase& operator=(F&& function) noexcept;
+
+    auto operator()(Args... args) const noexcept(Noexcept) -> R;
+
+    explicit operator bool() const noexcept;
+
+    ~InplaceFunctionBase() noexcept = default;
+private:
+    using VTable = InplaceVTable<R, Noexcept, Args...>;
+
+    template<typename T>
+    struct Local;
+
+    template<typename T>
+    struct Remote;
+
+    class Storage : public InplaceStorage<VTable, Capacity, Copyable> {
+    public:
+        template<typename Model, typename F>
+        void emplace(F&& function, Allocator* allocator) noexcept;
+
+        auto data() const noexcept -> void*;
+
+        auto vtable() const noexcept -> const VTable*;
+    };
+
+    template<typename T>
+    static constexpr auto check() noexcept -> bool;
+
+    Storage m_storage{};
+};
+
+template<typename Signature, std::size_t Capacity, bool Copyable>
+class BasicInplaceFunction;
+
+template<typename R, typename... Args, std::size_t Capacity, bool Copyable>
+class BasicInplaceFunction<R(Args...), Capacity, Copyable> :
+        public InplaceFunctionBase<false, Capacity, Copyable, R, Args...> {
+public:
+    using InplaceFunctionBase<false, Capacity, Copyable,
+          R, Args...>::InplaceFunctionBase;
+
+    using InplaceFunctionBase<false, Capacity, Copyable,
+          R, Args...>::operator=;
+};
+
+template<typename R, typename... Args, std::size_t Capacity, bool Copyable>
+class BasicInplaceFunction<R(Args...) noexcept, Capacity, Copyable> :
+        public InplaceFunctionBase<true, Capacity, Copyable, R, Args...> {
+public:
+    using InplaceFunctionBase<true, Capacity, Copyable,
+          R, Args...>::InplaceFunctionBase;
+
+    using InplaceFunctionBase<true, Capacity, Copyable,
+          R, Args...>::operator=;
+};
+
+/*
+ * Type-erased callable stored inline without heap allocation. Signature
+ * may be noexcept, then invoke path is noexcept too
+ */
+template<typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+using InplaceFunction = BasicInplaceFunction<Signature, Capacity, true>;
+
+/*
+ * Move-only variant of InplaceFunction, accepts move-only callables
+ */
+template<typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+using InplaceMoveFunction = BasicInplaceFunction<Signature, Capacity, false>;
+
+template<typename R, bool Noexcept, typename... Args> inline auto
+InplaceVTable<R, Noexcept, Args...>::empty() noexcept ->
+        const InplaceVTable* {
+    static constexpr InplaceVTable vtable{
+        [] (void*, Args&&...) noexcept(Noexcept) -> R { std::terminate(); },
+        [] (void*, void*) noexcept { },
+        [] (void*, const void*) { return true; },
+        [] (void*) noexcept { }
+    };
+
+    return &vtable;
+}
+
+template<typename VTable, std::size_t Capacity> inline
+InplaceStorage<VTable, Capacity, false>::InplaceStorage() noexcept :
+    m_buffer{},
+    m_vtable{VTable::empty()}
+{ }
+
+template<typename VTable, std::size_t Capacity> inline
+InplaceStorage<VTable, Capacity, false>::InplaceStorage(
+        InplaceStorage&& other) noexcept :
+    m_buffer{},
+    m_vtable{other.m_vtable}
+{
+    m_vtable->move(m_buffer, other.m_buffer);
+    other.m_vtable = VTable::empty();
+}
+
+template<typename VTable, std::size_t Capacity> inline auto
+InplaceStorage<VTable, Capacity, false>::operator=(
+        InplaceStorage&& other) noexcept -> InplaceStorage& {
+    if (this != &other) {
+        m_vtable->destroy(m_buffer);
+        m_vtable = other.m_vtable;
+        m_vtable->move(m_buffer, other.m_buffer);
+        other.m_vtable = VTable::empty();
+    }
+
+    return *this;
+}
+
+template<typename VTable, std::size_t Capacity> inline
+InplaceStorage<VTable, Capacity, false>::~InplaceStorage() noexcept {
+    m_vtable->destroy(m_buffer);
+}
+
+template<typename VTable, std::size_t Capacity> inline
+InplaceStorage<VTable, Capacity, true>::InplaceStorage(
+        const InplaceStorage& other) :
+    InplaceStorage<VTable, Capacity, false>{}
+{
+    if (!assign(other)) {
+        std::terminate();
+    }
+}
+
+template<typename VTable, std::size_t Capacity> inline auto
+InplaceStorage<VTable, Capacity, true>::operator=(
+        const InplaceStorage& other) -> InplaceStorage& {
+    if (!assign(other)) {
+        std::terminate();
+    }
+
+    return *this;
+}
+
+template<typename VTable, std::size_t Capacity> inline auto
+InplaceStorage<VTable, Capacity, true>::assign(
+        const InplaceStorage& other) -> bool {
+    if (this != &other) {
+        InplaceStorage copy{};
+
+        if (!other.m_vtable->copy(copy.m_buffer, other.m_buffer)) {
+            return false;
+        }
+
+        copy.m_vtable = other.m_vtable;
+        *this = std::move(copy);
+    }
+
+    return true;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename T>
+struct InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::Local {
+    static auto invoke(void* storage, Args&&... args) noexcept(Noexcept) -> R {
+        return static_cast<R>((*static_cast<T*>(storage))(
+                    std::forward<Args>(args)...));
+    }
+
+    static void move(void* dst, void* src) noexcept {
+        new (dst) T(std::move(*static_cast<T*>(src)));
+        static_cast<T*>(src)->~T();
+    }
+
+    static auto copy(void* dst, const void* src) -> bool {
+        if constexpr (Copyable) {
+            new (dst) T(*static_cast<const T*>(src));
+        }
+
+        return Copyable;
+    }
+
+    static void destroy(void* storage) noexcept {
+        static_cast<T*>(storage)->~T();
+    }
+
+    static constexpr VTable VTABLE{&invoke, &move, &copy, &destroy};
+};
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename T>
+struct InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::Remote {
+    struct Box {
+        T* object;
+        Allocator* allocator;
+    };
+
+    static_assert(sizeof(Box) <= Capacity,
+            "Capacity is too small to hold allocated callable");
+
+    static auto invoke(void* storage, Args&&... args) noexcept(Noexcept) -> R {
+        return static_cast<R>((*static_cast<Box*>(storage)->object)(
+                    std::forward<Args>(args)...));
+    }
+
+    static void move(void* dst, void* src) noexcept {
+        new (dst) Box(*static_cast<Box*>(src));
+    }
+
+    static auto copy(void* dst, const void* src) -> bool {
+        bool ok = false;
+
+        if constexpr (Copyable) {
+            const auto& box = *static_cast<const Box*>(src);
+            auto memory = box.allocator->allocate(sizeof(T));
+
+            if (memory != nullptr) {
+                new (dst) Box{new (memory) T(*box.object), box.allocator};
+                ok = true;
+            }
+        }
+
+        return ok;
+    }
+
+    static void destroy(void* storage) noexcept {
+        auto& box = *static_cast<Box*>(storage);
+
+        box.object->~T();
+        box.allocator->deallocate(box.object);
+    }
+
+    static constexpr VTable VTABLE{&invoke, &move, &copy, &destroy};
+};
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename Model, typename F> inline void
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::Storage::emplace(
+        F&& function, Allocator* allocator) noexcept {
+    using T = std::decay_t<F>;
+
+    this->m_vtable->destroy(this->m_buffer);
+    this->m_vtable = VTable::empty();
+
+    if constexpr (std::is_same<Model, Local<T>>::value) {
+        new (this->m_buffer) T(std::forward<F>(function));
+        this->m_vtable = &Model::VTABLE;
+    }
+    else {
+        auto memory = allocator->allocate(sizeof(T));
+
+        if (memory != nullptr) {
+            new (this->m_buffer) typename Model::Box{
+                new (memory) T(std::forward<F>(function)), allocator};
+            this->m_vtable = &Model::VTABLE;
+        }
+    }
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::Storage::data(
+        ) const noexcept -> void* {
+    return const_cast<unsigned char*>(this->m_buffer);
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::Storage::vtable(
+        ) const noexcept -> const VTable* {
+    return this->m_vtable;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename T> inline constexpr auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::fits(
+        ) noexcept -> bool {
+    return (sizeof(T) <= Capacity) && (alignof(T) <= ALIGN) &&
+        std::is_nothrow_move_constructible<T>::value;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename T> inline constexpr auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::check(
+        ) noexcept -> bool {
+    static_assert(std::disjunction<std::bool_constant<!Noexcept>,
+            std::is_nothrow_invocable_r<R, T&, Args...>>::value,
+            "Callable must be noexcept for noexcept signature");
+
+    static_assert(std::is_invocable_r<R, T&, Args...>::value,
+            "Callable cannot be invoked with function signature");
+
+    static_assert(std::disjunction<std::bool_constant<!Copyable>,
+            std::is_copy_constructible<T>>::value,
+            "Callable must be copyable, use InplaceMoveFunction instead");
+
+    static_assert(alignof(T) <= ALIGN, "Callable is over-aligned");
+
+    return true;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::
+InplaceFunctionBase(std::nullptr_t) noexcept
+{ }
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename F, typename> inline
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::
+InplaceFunctionBase(F&& function) noexcept {
+    using T = std::decay_t<F>;
+
+    static_assert(check<T>(), "");
+
+    static_assert(sizeof(T) <= Capacity, "Callable does not fit into "
+            "inline buffer, increase capacity or pass an allocator");
+
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+            "Callable with throwing move constructor cannot be stored "
+            "inline, pass an allocator");
+
+    m_storage.template emplace<Local<T>>(std::forward<F>(function), nullptr);
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename F> inline
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::
+InplaceFunctionBase(Allocator& allocator, F&& function) noexcept {
+    using T = std::decay_t<F>;
+
+    static_assert(check<T>(), "");
+
+    if constexpr (fits<T>()) {
+        m_storage.template emplace<Local<T>>(std::forward<F>(function),
+                &allocator);
+    }
+    else {
+        m_storage.template emplace<Remote<T>>(std::forward<F>(function),
+                &allocator);
+    }
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::operator=(
+        std::nullptr_t) noexcept -> InplaceFunctionBase& {
+    m_storage = Storage{};
+    return *this;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::assign(
+        const InplaceFunctionBase& other) -> bool {
+    static_assert(Copyable, "Move-only function cannot be copied");
+
+    return m_storage.assign(other.m_storage);
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args>
+template<typename F, typename> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::operator=(
+        F&& function) noexcept -> InplaceFunctionBase& {
+    using T = std::decay_t<F>;
+
+    static_assert(check<T>(), "");
+
+    static_assert(sizeof(T) <= Capacity, "Callable does not fit into "
+            "inline buffer, increase capacity or pass an allocator");
+
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+            "Callable with throwing move constructor cannot be stored "
+            "inline, pass an allocator");
+
+    m_storage.template emplace<Local<T>>(std::forward<F>(function), nullptr);
+
+    return *this;
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline auto
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::operator()(
+        Args... args) const noexcept(Noexcept) -> R {
+    return m_storage.vtable()->invoke(m_storage.data(),
+            std::forward<Args>(args)...);
+}
+
+template<bool Noexcept, std::size_t Capacity, bool Copyable,
+    typename R, typename... Args> inline
+InplaceFunctionBase<Noexcept, Capacity, Copyable, R, Args...>::
+operator bool() const noexcept {
+    return m_storage.vtable() != VTable::empty();
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_INPLACE_FUNCTION_HPP */
@@ -0,0 +1,301 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_INTRUSIVE_PTR_HPP
+#define ECXX_INTRUSIVE_PTR_HPP
+
+#include "ecxx/allocator.hpp"
+#include "ecxx/reference_counter.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace ecxx {
+
+template<typename T>
+class IntrusivePtr;
+
+template<typename T, typename... Args>
+auto allocate_intrusive(Allocator& allocator,
+        Args&&... args) noexcept -> IntrusivePtr<T>;
+
+/*
+ * Base class that embeds reference counter into object. Object created by
+ * allocate_intrusive is returned to its allocator with the last reference,
+ * other objects are never destroyed by IntrusivePtr. Derived classes that
+ * are released through pointer to base must have virtual destructor
+ */
+template<typename Counter = AtomicCounter>
+class RefCounted {
+public:
+    using counter_type = Counter;
+
+    RefCounted() noexcept = default;
+
+    /* Copied object starts with its own references */
+    RefCounted(const RefCounted& other) noexcept;
+
+    RefCounted& operator=(const RefCounted& other) noexcept;
+
+    void retain() const noexcept;
+
+    /* Returns true when the last reference was dropped */
+    auto release() const noexcept -> bool;
+
+    auto use_count() const noexcept -> std::size_t;
+
+    auto allocator() const noexcept -> Allocator*;
+protected:
+    ~RefCounted() noexcept = default;
+private:
+    template<typename T, typename... Args>
+    friend auto allocate_intrusive(Allocator& allocator,
+            Args&&... args) noexcept -> IntrusivePtr<T>;
+
+    mutable Counter m_counter{};
+    Allocator* m_allocator{nullptr};
+};
+
+/*
+ * Pointer to object that derives from RefCounted. It has size of raw
+ * pointer and can be recreated from raw pointer at any time
+ */
+template<typename T>
+class IntrusivePtr {
+public:
+    using element_type = T;
+
+    constexpr IntrusivePtr() noexcept = default;
+
+    constexpr IntrusivePtr(std::nullptr_t) noexcept;
+
+    /* Takes new reference, or adopts existing one when retain is false */
+    explicit IntrusivePtr(T* ptr, bool retain = true) noexcept;
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept;
+
+    IntrusivePtr(const IntrusivePtr& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    IntrusivePtr(IntrusivePtr<U>&& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    IntrusivePtr(const IntrusivePtr<U>& other) noexcept;
+
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept;
+
+    IntrusivePtr& operator=(const IntrusivePtr& other) noexcept;
+
+    IntrusivePtr& operator=(std::nullptr_t) noexcept;
+
+    auto get() const noexcept -> T*;
+
+    /* Gives up reference without releasing it */
+    auto detach() noexcept -> T*;
+
+    void reset() noexcept;
+
+    void swap(IntrusivePtr& other) noexcept;
+
+    auto operator*() const noexcept -> T&;
+
+    auto operator->() const noexcept -> T*;
+
+    explicit operator bool() const noexcept;
+
+    ~IntrusivePtr() noexcept;
+private:
+    T* m_pointer{nullptr};
+};
+
+template<typename Counter> inline
+RefCounted<Counter>::RefCounted(const RefCounted&) noexcept :
+    m_counter{},
+    m_allocator{nullptr}
+{ }
+
+template<typename Counter> inline auto
+RefCounted<Counter>::operator=(const RefCounted&) noexcept -> RefCounted& {
+    return *this;
+}
+
+template<typename Counter> inline void
+RefCounted<Counter>::retain() const noexcept {
+    m_counter.increment();
+}
+
+template<typename Counter> inline auto
+RefCounted<Counter>::release() const noexcept -> bool {
+    return m_counter.decrement();
+}
+
+template<typename Counter> inline auto
+RefCounted<Counter>::use_count() const noexcept -> std::size_t {
+    return m_counter.count();
+}
+
+template<typename Counter> inline auto
+RefCounted<Counter>::allocator() const noexcept -> Allocator* {
+    return m_allocator;
+}
+
+template<typename T> inline constexpr
+IntrusivePtr<T>::IntrusivePtr(std::nullptr_t) noexcept :
+    m_pointer{nullptr}
+{ }
+
+template<typename T> inline
+IntrusivePtr<T>::IntrusivePtr(T* ptr, bool retain) noexcept :
+    m_pointer{ptr}
+{
+    if (retain && (m_pointer != nullptr)) {
+        m_pointer->retain();
+    }
+}
+
+template<typename T> inline
+IntrusivePtr<T>::IntrusivePtr(IntrusivePtr&& other) noexcept :
+    m_pointer{other.detach()}
+{ }
+
+template<typename T> inline
+IntrusivePtr<T>::IntrusivePtr(const IntrusivePtr& other) noexcept :
+    IntrusivePtr{other.get()}
+{ }
+
+template<typename T>
+template<typename U, typename> inline
+IntrusivePtr<T>::IntrusivePtr(IntrusivePtr<U>&& other) noexcept :
+    m_pointer{other.detach()}
+{ }
+
+template<typename T>
+template<typename U, typename> inline
+IntrusivePtr<T>::IntrusivePtr(const IntrusivePtr<U>& other) noexcept :
+    IntrusivePtr{other.get()}
+{ }
+
+template<typename T> inline auto
+IntrusivePtr<T>::operator=(IntrusivePtr&& other) noexcept -> IntrusivePtr& {
+    IntrusivePtr{std::move(other)}.swap(*this);
+    return *this;
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::operator=(const IntrusivePtr& other) noexcept
+        -> IntrusivePtr& {
+    IntrusivePtr{other}.swap(*this);
+    return *this;
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::operator=(std::nullptr_t) noexcept -> IntrusivePtr& {
+    reset();
+    return *this;
+}
+
+template<typename T> inline
+IntrusivePtr<T>::~IntrusivePtr() noexcept {
+    reset();
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::get() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::detach() noexcept -> T* {
+    auto ptr = m_pointer;
+    m_pointer = nullptr;
+    return ptr;
+}
+
+template<typename T> inline void
+IntrusivePtr<T>::reset() noexcept {
+    auto ptr = detach();
+
+    if ((ptr != nullptr) && ptr->release()) {
+        auto allocator = ptr->allocator();
+
+        if (allocator != nullptr) {
+            allocator->destroy(ptr);
+        }
+    }
+}
+
+template<typename T> inline void
+IntrusivePtr<T>::swap(IntrusivePtr& other) noexcept {
+    std::swap(m_pointer, other.m_pointer);
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::operator*() const noexcept -> T& {
+    return *m_pointer;
+}
+
+template<typename T> inline auto
+IntrusivePtr<T>::operator->() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T> inline
+IntrusivePtr<T>::operator bool() const noexcept {
+    return m_pointer != nullptr;
+}
+
+template<typename T, typename... Args> inline auto
+allocate_intrusive(Allocator& allocator,
+        Args&&... args) noexcept -> IntrusivePtr<T> {
+    auto ptr = allocator.construct<T>(std::forward<Args>(args)...);
+
+    if (ptr != nullptr) {
+        using Base = RefCounted<typename T::counter_type>;
+
+        static_cast<Base*>(ptr)->m_allocator = &allocator;
+    }
+
+    return IntrusivePtr<T>{ptr, false};
+}
+
+template<typename T> static inline auto
+operator==(const IntrusivePtr<T>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() == nullptr;
+}
+
+template<typename T> static inline auto
+operator!=(const IntrusivePtr<T>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() != nullptr;
+}
+
+template<typename T, typename U> static inline auto
+operator==(const IntrusivePtr<T>& lhs,
+        const IntrusivePtr<U>& rhs) noexcept -> bool {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U> static inline auto
+operator!=(const IntrusivePtr<T>& lhs,
+        const IntrusivePtr<U>& rhs) noexcept -> bool {
+    return lhs.get() != rhs.get();
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_INTRUSIVE_PTR_HPP */
@@ -0,0 +1,95 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_IO_HPP
+#define ECXX_IO_HPP
+
+#include "ecxx/span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecxx {
+namespace io {
+
+using ConstBuffer = Span<const std::uint8_t>;
+
+using MutableBuffer = Span<std::uint8_t>;
+
+/* Most non-empty fragments passed to single system call */
+static constexpr std::size_t MAX_FRAGMENTS{64u};
+
+/*
+ * Transfer fragments with single readv, writev, recvmsg or sendmsg call,
+ * empty fragments are skipped. Return number of transferred bytes or
+ * negative errno value. Lists with more than MAX_FRAGMENTS non-empty
+ * fragments are rejected with -EMSGSIZE without transferring anything
+ */
+auto read(int fd, const Span<MutableBuffer>& fragments) noexcept
+    -> std::ptrdiff_t;
+
+auto write(int fd, const Span<ConstBuffer>& fragments) noexcept
+    -> std::ptrdiff_t;
+
+auto receive(int fd, const Span<MutableBuffer>& fragments,
+        int flags = 0) noexcept -> std::ptrdiff_t;
+
+auto send(int fd, const Span<ConstBuffer>& fragments,
+        int flags = 0) noexcept -> std::ptrdiff_t;
+
+/*
+ * Write or send all fragments to stream, partial transfers and interrupted
+ * calls are retried, longer lists are passed MAX_FRAGMENTS at a time.
+ * Fragments are consumed in place, on return they hold what is left to
+ * transfer. Return number of transferred bytes. Error is returned only when
+ * nothing was transferred, after partial transfer the next call reports it
+ */
+auto write_all(int fd, Span<ConstBuffer>& fragments) noexcept
+    -> std::ptrdiff_t;
+
+auto send_all(int fd, Span<ConstBuffer>& fragments,
+        int flags = 0) noexcept -> std::ptrdiff_t;
+
+/*
+ * Drops n transferred bytes from the front of fragments and returns
+ * fragments left to transfer, the first of them is shortened in place
+ */
+template<typename T>
+auto consume(Span<Span<T>> fragments, std::size_t n) noexcept
+    -> Span<Span<T>>;
+
+template<typename T> inline auto
+consume(Span<Span<T>> fragments, std::size_t n) noexcept -> Span<Span<T>> {
+    std::size_t index = 0;
+
+    while ((index < fragments.size()) && (n >= fragments[index].size())) {
+        n -= fragments[index].size();
+        ++index;
+    }
+
+    fragments = fragments.subspan(index);
+
+    if (!fragments.empty() && (n != 0)) {
+        fragments[0] = fragments[0].subspan(n);
+    }
+
+    return fragments;
+}
+
+} /* namespace io */
+} /* namespace ecxx */
+
+#endif /* ECXX_IO_HPP */
@@ -0,0 +1,87 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_IO_MESSAGE_HPP
+#define ECXX_IO_MESSAGE_HPP
+
+#include "ecxx/io.hpp"
+#include "ecxx/allocator.hpp"
+
+namespace ecxx {
+namespace io {
+
+/*
+ * Fragmented message assembled without flattening. Fragments either
+ * reference caller's data or own buffers taken from allocator, fragment
+ * list itself also lives in allocator memory
+ */
+class Message {
+public:
+    explicit Message(Allocator& allocator) noexcept;
+
+    Message(Message&& other) noexcept = delete;
+
+    Message(const Message& other) noexcept = delete;
+
+    Message& operator=(Message&& other) noexcept = delete;
+
+    Message& operator=(const Message& other) noexcept = delete;
+
+    /*
+     * Appends buffer of n bytes owned by message and returns it for filling.
+     * Returned buffer is empty when allocation fails
+     */
+    auto allocate(std::size_t n) noexcept -> MutableBuffer;
+
+    /* Appends reference to data that must outlive message */
+    auto append(ConstBuffer data) noexcept -> bool;
+
+    /* Fragments may be consumed in place by write_all() or send_all() */
+    auto fragments() noexcept -> Span<ConstBuffer>;
+
+    auto count() const noexcept -> std::size_t;
+
+    /* Total number of bytes in all fragments */
+    auto size() const noexcept -> std::size_t;
+
+    /* Drops all fragments and returns owned buffers to allocator */
+    void clear() noexcept;
+
+    ~Message() noexcept;
+private:
+    auto push(ConstBuffer data, void* owned) noexcept -> bool;
+
+    Allocator& m_allocator;
+    ConstBuffer* m_fragments{nullptr};
+    void** m_owned{nullptr};
+    std::size_t m_count{0u};
+    std::size_t m_capacity{0u};
+};
+
+inline auto
+Message::fragments() noexcept -> Span<ConstBuffer> {
+    return {m_fragments, m_count};
+}
+
+inline auto
+Message::count() const noexcept -> std::size_t {
+    return m_count;
+}
+
+} /* namespace io */
+} /* namespace ecxx */
+
+#endif /* ECXX_IO_MESSAGE_HPP */
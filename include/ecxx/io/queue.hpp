@@ -0,0 +1,145 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_IO_QUEUE_HPP
+#define ECXX_IO_QUEUE_HPP
+
+#include "ecxx/io.hpp"
+#include "ecxx/allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecxx {
+namespace io {
+
+/*
+ * Submission queue that batches scatter/gather operations, many of them
+ * are passed to kernel with single system call. Uses io_uring when kernel
+ * supports it, otherwise operations run synchronously in submit(). Requests
+ * are allocated from allocator and released when their completion is
+ * reaped. Fragment lists are copied into request, they only have to stay
+ * valid until read(), write(), send() or receive() returns, buffers until
+ * operation completes. Empty fragments are skipped, operation with more
+ * than IOV_MAX non-empty fragments is rejected instead of being truncated.
+ * Destructor cancels operations still in flight and waits for them
+ */
+class Queue {
+public:
+    struct Completion {
+        std::uint64_t data;
+        std::ptrdiff_t result;
+    };
+
+    /* Use current file position */
+    static constexpr std::int64_t CURRENT{-1};
+
+    explicit Queue(Allocator& allocator, std::size_t entries = 64u,
+            bool asynchronous = true) noexcept;
+
+    Queue(Queue&& other) noexcept = delete;
+
+    Queue(const Queue& other) noexcept = delete;
+
+    Queue& operator=(Queue&& other) noexcept = delete;
+
+    Queue& operator=(const Queue& other) noexcept = delete;
+
+    /* True when operations are executed by io_uring */
+    auto asynchronous() const noexcept -> bool;
+
+    auto capacity() const noexcept -> std::size_t;
+
+    /* Operations queued or in flight whose completion was not reaped */
+    auto pending() const noexcept -> std::size_t;
+
+    /*
+     * Queue operation, data is returned in its completion. Return false
+     * when queue is full, fragments exceed IOV_MAX or allocation fails
+     */
+    auto read(int fd, const Span<MutableBuffer>& fragments,
+            std::uint64_t data, std::int64_t offset = CURRENT) noexcept
+        -> bool;
+
+    auto write(int fd, const Span<ConstBuffer>& fragments,
+            std::uint64_t data, std::int64_t offset = CURRENT) noexcept
+        -> bool;
+
+    auto receive(int fd, const Span<MutableBuffer>& fragments,
+            std::uint64_t data, int flags = 0) noexcept -> bool;
+
+    auto send(int fd, const Span<ConstBuffer>& fragments,
+            std::uint64_t data, int flags = 0) noexcept -> bool;
+
+    /* Return number of submitted operations or negative errno value */
+    auto submit() noexcept -> std::ptrdiff_t;
+
+    /*
+     * Submit queued operations, wait until at least min of them completes
+     * and reap up to completions.size() of them. Return number of reaped
+     * completions or negative errno value
+     */
+    auto complete(Span<Completion> completions,
+            std::size_t min = 0) noexcept -> std::ptrdiff_t;
+
+    ~Queue() noexcept;
+private:
+    struct Ring;
+
+    struct Request;
+
+    template<typename T>
+    auto prepare(std::uint8_t operation, int fd,
+            const Span<Span<T>>& fragments, std::uint64_t data,
+            std::int64_t offset, int flags) noexcept -> bool;
+
+    void release(Request* request) noexcept;
+
+    void unlink(Request* request) noexcept;
+
+    /* Ask kernel to cancel all operations in flight */
+    void cancel() noexcept;
+
+    Allocator& m_allocator;
+    Ring* m_ring{nullptr};
+    Request* m_queued{nullptr};
+    Request* m_queued_last{nullptr};
+    Request* m_completed{nullptr};
+    Request* m_completed_last{nullptr};
+    Request* m_inflight{nullptr};
+    std::size_t m_capacity{0u};
+    std::size_t m_pending{0u};
+};
+
+inline auto
+Queue::asynchronous() const noexcept -> bool {
+    return m_ring != nullptr;
+}
+
+inline auto
+Queue::capacity() const noexcept -> std::size_t {
+    return m_capacity;
+}
+
+inline auto
+Queue::pending() const noexcept -> std::size_t {
+    return m_pending;
+}
+
+} /* namespace io */
+} /* namespace ecxx */
+
+#endif /* ECXX_IO_QUEUE_HPP */
@@ -0,0 +1,173 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ECXX_PARALLEL_HPP
+#define ECXX_PARALLEL_HPP
+
+#include "ecxx/span.hpp"
+#include "ecxx/executor.hpp"
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace ecxx {
+
+/*
+ * Splits span into sub-spans of grain elements. Grain is rounded up to
+ * a multiple of a cache line and sub-span boundaries are placed on cache
+ * lines, so that workers never write to the same line.
+ */
+template<typename T>
+class Partition {
+public:
+    Partition(const Span<T>& span, std::size_t grain) noexcept;
+
+    constexpr auto chunks() const noexcept -> std::size_t;
+
+    constexpr auto operator()(std::size_t first,
+            std::size_t last) const noexcept -> Span<T>;
+private:
+    Span<T> m_span;
+    std::size_t m_grain;
+    std::size_t m_skew;
+};
+
+template<typename T, typename F>
+void parallel_for(Executor& executor, const Span<T>& span, std::size_t grain,
+        F&& function) noexcept;
+
+/*
+ * Each worker folds its sub-spans with function(R, Span<T>) -> R into own
+ * accumulator that starts from identity. Accumulators are merged with
+ * combine(R, R) -> R in unspecified order, it must be associative and
+ * commutative.
+ */
+template<typename R, typename T, typename F, typename C>
+auto parallel_reduce(Executor& executor, const Span<T>& span,
+        std::size_t grain, R identity, F&& function,
+        C&& combine) noexcept -> R;
+
+template<typename T> inline
+Partition<T>::Partition(const Span<T>& span, std::size_t grain) noexcept :
+    m_span{span},
+    m_grain{1u},
+    m_skew{0u}
+{
+    constexpr std::size_t line = ((Executor::CACHE_LINE % sizeof(T)) == 0)
+        ? (Executor::CACHE_LINE / sizeof(T)) : 1u;
+
+    const auto address = std::uintptr_t(span.data());
+    std::size_t head = 0;
+
+    if ((line > 1) && ((address % sizeof(T)) == 0)) {
+        head = ((Executor::CACHE_LINE - (address % Executor::CACHE_LINE)) %
+            Executor::CACHE_LINE) / sizeof(T);
+    }
+
+    m_grain = ((std::max<std::size_t>(grain, 1u) + line - 1u) / line) * line;
+    m_skew = (m_grain - (std::min(head, span.size()) % m_grain)) % m_grain;
+}
+
+template<typename T> inline constexpr auto
+Partition<T>::chunks() const noexcept -> std::size_t {
+    return (m_span.size() + m_skew + m_grain - 1u) / m_grain;
+}
+
+template<typename T> inline constexpr auto
+Partition<T>::operator()(std::size_t first,
+        std::size_t last) const noexcept -> Span<T> {
+    const auto begin = (first != 0) ? ((first * m_grain) - m_skew) : 0u;
+    const auto end = std::min((last * m_grain) - m_skew, m_span.size());
+
+    return m_span.subspan(begin, end - begin);
+}
+
+template<typename T, typename F>
+void parallel_for(Executor& executor, const Span<T>& span, std::size_t grain,
+        F&& function) noexcept {
+    struct Context {
+        static void call(void* context, std::size_t,
+                std::size_t first, std::size_t last) noexcept {
+            auto self = static_cast<Context*>(context);
+            (*self->function)(self->partition(first, last));
+        }
+
+        Partition<T> partition;
+        std::remove_reference_t<F>* function;
+    } context{Partition<T>{span, grain}, &function};
+
+    executor.run(Context::call, &context, context.partition.chunks());
+}
+
+template<typename R, typename T, typename F, typename C>
+auto parallel_reduce(Executor& executor, const Span<T>& span,
+        std::size_t grain, R identity, F&& function,
+        C&& combine) noexcept -> R {
+    constexpr std::size_t stride = ((sizeof(R) + Executor::CACHE_LINE - 1u) /
+        Executor::CACHE_LINE) * Executor::CACHE_LINE;
+
+    const auto workers = executor.workers();
+
+    /* Per-worker accumulators, one cache line apart */
+    auto memory = executor.allocator().allocate(
+            (workers * stride) + Executor::CACHE_LINE);
+
+    if (memory == nullptr) {
+        return function(std::move(identity), span);
+    }
+
+    const auto scratch = (std::uintptr_t(memory) + Executor::CACHE_LINE - 1u) &
+        ~std::uintptr_t(Executor::CACHE_LINE - 1u);
+
+    for (std::size_t i = 0; i < workers; ++i) {
+        new (reinterpret_cast<void*>(scratch + (i * stride))) R{identity};
+    }
+
+    struct Context {
+        static void call(void* context, std::size_t worker,
+                std::size_t first, std::size_t last) noexcept {
+            auto self = static_cast<Context*>(context);
+            auto& accumulator = *reinterpret_cast<R*>(
+                    self->scratch + (worker * stride));
+
+            accumulator = (*self->function)(std::move(accumulator),
+                    self->partition(first, last));
+        }
+
+        Partition<T> partition;
+        std::remove_reference_t<F>* function;
+        std::uintptr_t scratch;
+    } context{Partition<T>{span, grain}, &function, scratch};
+
+    executor.run(Context::call, &context, context.partition.chunks());
+
+    for (std::size_t i = 0; i < workers; ++i) {
+        auto& accumulator = *reinterpret_cast<R*>(scratch + (i * stride));
+        identity = combine(std::move(identity), std::move(accumulator));
+        accumulator.~R();
+    }
+
+    executor.allocator().deallocate(memory);
+
+    return identity;
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_PARALLEL_HPP */
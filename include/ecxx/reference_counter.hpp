@@ -0,0 +1,112 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_REFERENCE_COUNTER_HPP
+#define ECXX_REFERENCE_COUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace ecxx {
+
+/*
+ * Reference counters used by SharedPtr and RefCounted. Both start at one,
+ * the creator holds the first reference. decrement() returns true when the
+ * last reference was dropped
+ */
+class AtomicCounter {
+public:
+    constexpr AtomicCounter() noexcept = default;
+
+    AtomicCounter(AtomicCounter&& other) noexcept = delete;
+
+    AtomicCounter(const AtomicCounter& other) noexcept = delete;
+
+    AtomicCounter& operator=(AtomicCounter&& other) noexcept = delete;
+
+    AtomicCounter& operator=(const AtomicCounter& other) noexcept = delete;
+
+    void increment() noexcept;
+
+    auto decrement() noexcept -> bool;
+
+    auto count() const noexcept -> std::size_t;
+
+    ~AtomicCounter() noexcept = default;
+private:
+    std::atomic<std::size_t> m_count{1u};
+};
+
+/*
+ * Plain counter for objects that never leave single thread
+ */
+class LocalCounter {
+public:
+    constexpr LocalCounter() noexcept = default;
+
+    LocalCounter(LocalCounter&& other) noexcept = delete;
+
+    LocalCounter(const LocalCounter& other) noexcept = delete;
+
+    LocalCounter& operator=(LocalCounter&& other) noexcept = delete;
+
+    LocalCounter& operator=(const LocalCounter& other) noexcept = delete;
+
+    void increment() noexcept;
+
+    auto decrement() noexcept -> bool;
+
+    auto count() const noexcept -> std::size_t;
+
+    ~LocalCounter() noexcept = default;
+private:
+    std::size_t m_count{1u};
+};
+
+inline void
+AtomicCounter::increment() noexcept {
+    m_count.fetch_add(1u, std::memory_order_relaxed);
+}
+
+inline auto
+AtomicCounter::decrement() noexcept -> bool {
+    /* Release publishes writes to object, acquire orders its destruction */
+    return m_count.fetch_sub(1u, std::memory_order_acq_rel) == 1u;
+}
+
+inline auto
+AtomicCounter::count() const noexcept -> std::size_t {
+    return m_count.load(std::memory_order_relaxed);
+}
+
+inline void
+LocalCounter::increment() noexcept {
+    ++m_count;
+}
+
+inline auto
+LocalCounter::decrement() noexcept -> bool {
+    return --m_count == 0u;
+}
+
+inline auto
+LocalCounter::count() const noexcept -> std::size_t {
+    return m_count;
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_REFERENCE_COUNTER_HPP */
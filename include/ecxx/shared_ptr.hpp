@@ -0,0 +1,397 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_SHARED_PTR_HPP
+#define ECXX_SHARED_PTR_HPP
+
+#include "ecxx/allocator.hpp"
+#include "ecxx/reference_counter.hpp"
+
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace ecxx {
+
+/*
+ * Header placed in front of shared object in the same allocation. Dispose
+ * destroys object and returns whole block to allocator
+ */
+template<typename Counter>
+class SharedControl {
+public:
+    using Dispose = void (*)(SharedControl* control) noexcept;
+
+    SharedControl(Allocator& allocator, Dispose dispose) noexcept;
+
+    SharedControl(SharedControl&& other) noexcept = delete;
+
+    SharedControl(const SharedControl& other) noexcept = delete;
+
+    SharedControl& operator=(SharedControl&& other) noexcept = delete;
+
+    SharedControl& operator=(const SharedControl& other) noexcept = delete;
+
+    void retain() noexcept;
+
+    void release() noexcept;
+
+    auto use_count() const noexcept -> std::size_t;
+
+    auto allocator() const noexcept -> Allocator&;
+protected:
+    ~SharedControl() noexcept = default;
+private:
+    Counter m_counter{};
+    Allocator& m_allocator;
+    Dispose m_dispose;
+};
+
+template<typename T, typename Counter>
+class SharedBlock final : public SharedControl<Counter> {
+public:
+    template<typename... Args>
+    SharedBlock(Allocator& allocator, Args&&... args) noexcept;
+
+    auto object() noexcept -> T*;
+
+    ~SharedBlock() noexcept = default;
+private:
+    static void dispose(SharedControl<Counter>* control) noexcept;
+
+    T m_object;
+};
+
+template<typename T, typename Counter = AtomicCounter>
+class SharedPtr;
+
+template<typename T, typename Counter = AtomicCounter, typename... Args>
+auto allocate_shared(Allocator& allocator,
+        Args&&... args) noexcept -> SharedPtr<T, Counter>;
+
+/*
+ * Shared owner of object created by allocate_shared. Counter selects
+ * between atomic and plain reference counting, pointers with different
+ * counters do not mix
+ */
+template<typename T, typename Counter>
+class SharedPtr {
+public:
+    using element_type = T;
+
+    using counter_type = Counter;
+
+    constexpr SharedPtr() noexcept = default;
+
+    constexpr SharedPtr(std::nullptr_t) noexcept;
+
+    SharedPtr(SharedPtr&& other) noexcept;
+
+    SharedPtr(const SharedPtr& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    SharedPtr(SharedPtr<U, Counter>&& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    SharedPtr(const SharedPtr<U, Counter>& other) noexcept;
+
+    /* Shares ownership with other but points to ptr, usually its member */
+    template<typename U>
+    SharedPtr(const SharedPtr<U, Counter>& other, T* ptr) noexcept;
+
+    SharedPtr& operator=(SharedPtr&& other) noexcept;
+
+    SharedPtr& operator=(const SharedPtr& other) noexcept;
+
+    SharedPtr& operator=(std::nullptr_t) noexcept;
+
+    auto get() const noexcept -> T*;
+
+    auto use_count() const noexcept -> std::size_t;
+
+    void reset() noexcept;
+
+    void swap(SharedPtr& other) noexcept;
+
+    auto operator*() const noexcept -> T&;
+
+    auto operator->() const noexcept -> T*;
+
+    explicit operator bool() const noexcept;
+
+    ~SharedPtr() noexcept;
+private:
+    template<typename U, typename C>
+    friend class SharedPtr;
+
+    template<typename U, typename C, typename... Args>
+    friend auto allocate_shared(Allocator& allocator,
+            Args&&... args) noexcept -> SharedPtr<U, C>;
+
+    SharedPtr(T* ptr, SharedControl<Counter>* control) noexcept;
+
+    T* m_pointer{nullptr};
+    SharedControl<Counter>* m_control{nullptr};
+};
+
+template<typename T>
+using LocalSharedPtr = SharedPtr<T, LocalCounter>;
+
+template<typename T, typename... Args>
+auto allocate_local_shared(Allocator& allocator,
+        Args&&... args) noexcept -> LocalSharedPtr<T>;
+
+template<typename Counter> inline
+SharedControl<Counter>::SharedControl(Allocator& allocator,
+        Dispose dispose) noexcept :
+    m_allocator{allocator},
+    m_dispose{dispose}
+{ }
+
+template<typename Counter> inline void
+SharedControl<Counter>::retain() noexcept {
+    m_counter.increment();
+}
+
+template<typename Counter> inline void
+SharedControl<Counter>::release() noexcept {
+    if (m_counter.decrement()) {
+        m_dispose(this);
+    }
+}
+
+template<typename Counter> inline auto
+SharedControl<Counter>::use_count() const noexcept -> std::size_t {
+    return m_counter.count();
+}
+
+template<typename Counter> inline auto
+SharedControl<Counter>::allocator() const noexcept -> Allocator& {
+    return m_allocator;
+}
+
+template<typename T, typename Counter>
+template<typename... Args> inline
+SharedBlock<T, Counter>::SharedBlock(Allocator& allocator,
+        Args&&... args) noexcept :
+    SharedControl<Counter>{allocator, dispose},
+    m_object(std::forward<Args>(args)...)
+{ }
+
+template<typename T, typename Counter> inline auto
+SharedBlock<T, Counter>::object() noexcept -> T* {
+    return &m_object;
+}
+
+template<typename T, typename Counter> inline void
+SharedBlock<T, Counter>::dispose(SharedControl<Counter>* control) noexcept {
+    auto block = static_cast<SharedBlock*>(control);
+    auto& allocator = block->allocator();
+
+    block->~SharedBlock();
+    allocator.deallocate(block);
+}
+
+template<typename T, typename Counter> inline constexpr
+SharedPtr<T, Counter>::SharedPtr(std::nullptr_t) noexcept :
+    m_pointer{nullptr},
+    m_control{nullptr}
+{ }
+
+template<typename T, typename Counter> inline
+SharedPtr<T, Counter>::SharedPtr(T* ptr,
+        SharedControl<Counter>* control) noexcept :
+    m_pointer{ptr},
+    m_control{control}
+{ }
+
+template<typename T, typename Counter> inline
+SharedPtr<T, Counter>::SharedPtr(SharedPtr&& other) noexcept :
+    m_pointer{other.m_pointer},
+    m_control{other.m_control}
+{
+    other.m_pointer = nullptr;
+    other.m_control = nullptr;
+}
+
+template<typename T, typename Counter> inline
+SharedPtr<T, Counter>::SharedPtr(const SharedPtr& other) noexcept :
+    m_pointer{other.m_pointer},
+    m_control{other.m_control}
+{
+    if (m_control != nullptr) {
+        m_control->retain();
+    }
+}
+
+template<typename T, typename Counter>
+template<typename U, typename> inline
+SharedPtr<T, Counter>::SharedPtr(SharedPtr<U, Counter>&& other) noexcept :
+    m_pointer{other.m_pointer},
+    m_control{other.m_control}
+{
+    other.m_pointer = nullptr;
+    other.m_control = nullptr;
+}
+
+template<typename T, typename Counter>
+template<typename U, typename> inline
+SharedPtr<T, Counter>::SharedPtr(
+        const SharedPtr<U, Counter>& other) noexcept :
+    m_pointer{other.m_pointer},
+    m_control{other.m_control}
+{
+    if (m_control != nullptr) {
+        m_control->retain();
+    }
+}
+
+template<typename T, typename Counter>
+template<typename U> inline
+SharedPtr<T, Counter>::SharedPtr(const SharedPtr<U, Counter>& other,
+        T* ptr) noexcept :
+    m_pointer{ptr},
+    m_control{other.m_control}
+{
+    if (m_control != nullptr) {
+        m_control->retain();
+    }
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::operator=(SharedPtr&& other) noexcept -> SharedPtr& {
+    SharedPtr{std::move(other)}.swap(*this);
+    return *this;
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::operator=(
+        const SharedPtr& other) noexcept -> SharedPtr& {
+    SharedPtr{other}.swap(*this);
+    return *this;
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::operator=(std::nullptr_t) noexcept -> SharedPtr& {
+    reset();
+    return *this;
+}
+
+template<typename T, typename Counter> inline
+SharedPtr<T, Counter>::~SharedPtr() noexcept {
+    reset();
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::get() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::use_count() const noexcept -> std::size_t {
+    return (m_control != nullptr) ? m_control->use_count() : 0u;
+}
+
+template<typename T, typename Counter> inline void
+SharedPtr<T, Counter>::reset() noexcept {
+    auto control = m_control;
+
+    m_pointer = nullptr;
+    m_control = nullptr;
+
+    if (control != nullptr) {
+        control->release();
+    }
+}
+
+template<typename T, typename Counter> inline void
+SharedPtr<T, Counter>::swap(SharedPtr& other) noexcept {
+    std::swap(m_pointer, other.m_pointer);
+    std::swap(m_control, other.m_control);
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::operator*() const noexcept -> T& {
+    return *m_pointer;
+}
+
+template<typename T, typename Counter> inline auto
+SharedPtr<T, Counter>::operator->() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T, typename Counter> inline
+SharedPtr<T, Counter>::operator bool() const noexcept {
+    return m_pointer != nullptr;
+}
+
+template<typename T, typename Counter, typename... Args> inline auto
+allocate_shared(Allocator& allocator,
+        Args&&... args) noexcept -> SharedPtr<T, Counter> {
+    using Block = SharedBlock<T, Counter>;
+
+    static_assert(alignof(Block) <= alignof(std::max_align_t),
+            "Over-aligned types are not supported");
+
+    SharedPtr<T, Counter> ptr;
+    void* memory = allocator.allocate(sizeof(Block));
+
+    if (memory != nullptr) {
+        auto block = ::new (memory) Block(allocator,
+                std::forward<Args>(args)...);
+
+        ptr.m_pointer = block->object();
+        ptr.m_control = block;
+    }
+
+    return ptr;
+}
+
+template<typename T, typename... Args> inline auto
+allocate_local_shared(Allocator& allocator,
+        Args&&... args) noexcept -> LocalSharedPtr<T> {
+    return allocate_shared<T, LocalCounter>(allocator,
+            std::forward<Args>(args)...);
+}
+
+template<typename T, typename C> static inline auto
+operator==(const SharedPtr<T, C>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() == nullptr;
+}
+
+template<typename T, typename C> static inline auto
+operator!=(const SharedPtr<T, C>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() != nullptr;
+}
+
+template<typename T, typename U, typename C> static inline auto
+operator==(const SharedPtr<T, C>& lhs,
+        const SharedPtr<U, C>& rhs) noexcept -> bool {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U, typename C> static inline auto
+operator!=(const SharedPtr<T, C>& lhs,
+        const SharedPtr<U, C>& rhs) noexcept -> bool {
+    return lhs.get() != rhs.get();
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_SHARED_PTR_HPP */
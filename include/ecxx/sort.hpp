@@ -0,0 +1,533 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_SORT_HPP
+#define ECXX_SORT_HPP
+
+#include "ecxx/span.hpp"
+#include "ecxx/executor.hpp"
+#include "ecxx/allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace ecxx {
+
+/*
+ * Maps arithmetic key to unsigned integer with the same order. Negative
+ * zero sorts before positive zero, NaNs sort to both ends by their sign
+ */
+template<typename K, typename = void>
+struct RadixKey;
+
+template<typename K>
+struct RadixKey<K, std::enable_if_t<std::is_unsigned<K>::value>> {
+    using type = K;
+
+    static constexpr auto encode(K key) noexcept -> type {
+        return key;
+    }
+};
+
+template<typename K>
+struct RadixKey<K, std::enable_if_t<std::is_integral<K>::value &&
+        std::is_signed<K>::value>> {
+    using type = std::make_unsigned_t<K>;
+
+    static constexpr auto encode(K key) noexcept -> type {
+        return type(type(key) ^ (type(1) << ((8u * sizeof(type)) - 1u)));
+    }
+};
+
+template<typename K>
+struct RadixKey<K, std::enable_if_t<std::is_floating_point<K>::value>> {
+    static_assert((sizeof(K) == 4u) || (sizeof(K) == 8u),
+            "Only 32-bit and 64-bit floating point keys are supported");
+
+    using type = std::conditional_t<sizeof(K) == 4u,
+          std::uint32_t, std::uint64_t>;
+
+    static auto encode(K key) noexcept -> type {
+        constexpr type sign = type(1) << ((8u * sizeof(type)) - 1u);
+        type bits;
+
+        std::memcpy(&bits, &key, sizeof(bits));
+
+        /* Negative values have reversed order of magnitude bits */
+        return bits ^ (((bits & sign) != 0) ? ~type(0) : sign);
+    }
+};
+
+/* Key of arithmetic element is element itself */
+struct Identity {
+    template<typename T>
+    constexpr auto operator()(const T& value) const noexcept -> const T& {
+        return value;
+    }
+};
+
+/*
+ * Least significant digit radix sort with 8-bit digits. It is stable,
+ * passes whose digit is the same for all elements are skipped. Scratch
+ * buffer of span size comes from allocator, when allocation fails elements
+ * are sorted with std::sort and order of equal keys is unspecified
+ */
+template<typename T, typename Key = Identity>
+class RadixSort {
+public:
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Elements are moved with plain copies");
+
+    using key_type = std::decay_t<decltype(std::declval<const Key&>()(
+                std::declval<const T&>()))>;
+
+    using bits_type = typename RadixKey<key_type>::type;
+
+    static constexpr std::size_t DIGITS{sizeof(bits_type)};
+
+    static constexpr std::size_t RADIX{256u};
+
+    /* Below this size insertion sort wins */
+    static constexpr std::size_t THRESHOLD{64u};
+
+    /* Minimal number of elements per chunk in parallel mode */
+    static constexpr std::size_t GRAIN{16384u};
+
+    RadixSort(Span<T> span, Key key) noexcept;
+
+    void sort(Allocator& allocator) noexcept;
+
+    void sort(Executor& executor) noexcept;
+private:
+    using Counts = std::size_t[RADIX];
+
+    auto bits(const T& value) const noexcept -> bits_type;
+
+    static auto digit(bits_type value, std::size_t pass) noexcept
+        -> std::size_t;
+
+    void histogram(const T* first, const T* last,
+            Counts* counts) const noexcept;
+
+    void histogram(const T* first, const T* last, std::size_t pass,
+            Counts& counts) const noexcept;
+
+    void scatter(const T* first, const T* last, T* output, std::size_t pass,
+            Counts& offsets) const noexcept;
+
+    void fallback() noexcept;
+
+    Span<T> m_span;
+    Key m_key;
+};
+
+template<typename T, typename Key = Identity>
+void sort(Allocator& allocator, Span<T> span, Key key = {}) noexcept;
+
+/*
+ * Each radix pass runs histogram and scatter phases on executor workers,
+ * scratch memory comes from executor allocator
+ */
+template<typename T, typename Key = Identity>
+void sort(Executor& executor, Span<T> span, Key key = {}) noexcept;
+
+template<typename T, typename Compare = std::less<>>
+void insertion_sort(Span<T> span, Compare compare = {}) noexcept;
+
+/*
+ * Moves elements that satisfy predicate in front of the others and returns
+ * their count. Works on blocks, predicate results are collected into offset
+ * buffers without branches and only misplaced elements are swapped
+ */
+template<typename T, typename Predicate>
+auto partition(Span<T> span, Predicate predicate) noexcept -> std::size_t;
+
+/*
+ * Quickselect on top of partition() with median of three pivots and three
+ * way split for duplicated keys, falls back to std::nth_element when
+ * recursion gets too deep
+ */
+template<typename T, typename Compare = std::less<>>
+void nth_element(Span<T> span, std::size_t n,
+        Compare compare = {}) noexcept;
+
+template<typename T, typename Key> inline
+RadixSort<T, Key>::RadixSort(Span<T> span, Key key) noexcept :
+    m_span{span},
+    m_key{std::move(key)}
+{ }
+
+template<typename T, typename Key> inline auto
+RadixSort<T, Key>::bits(const T& value) const noexcept -> bits_type {
+    return RadixKey<key_type>::encode(m_key(value));
+}
+
+template<typename T, typename Key> inline auto
+RadixSort<T, Key>::digit(bits_type value, std::size_t pass) noexcept
+        -> std::size_t {
+    return std::size_t(value >> (8u * pass)) & (RADIX - 1u);
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::histogram(const T* first, const T* last,
+        Counts* counts) const noexcept {
+    /* All digits are counted in one pass over data, unrolled by four */
+    for (; (last - first) >= 4; first += 4) {
+        const bits_type values[4]{bits(first[0]), bits(first[1]),
+            bits(first[2]), bits(first[3])};
+
+        for (std::size_t pass = 0; pass < DIGITS; ++pass) {
+            ++counts[pass][digit(values[0], pass)];
+            ++counts[pass][digit(values[1], pass)];
+            ++counts[pass][digit(values[2], pass)];
+            ++counts[pass][digit(values[3], pass)];
+        }
+    }
+
+    for (; first < last; ++first) {
+        const auto value = bits(*first);
+
+        for (std::size_t pass = 0; pass < DIGITS; ++pass) {
+            ++counts[pass][digit(value, pass)];
+        }
+    }
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::histogram(const T* first, const T* last, std::size_t pass,
+        Counts& counts) const noexcept {
+    std::fill(std::begin(counts), std::end(counts), 0u);
+
+    for (; (last - first) >= 4; first += 4) {
+        ++counts[digit(bits(first[0]), pass)];
+        ++counts[digit(bits(first[1]), pass)];
+        ++counts[digit(bits(first[2]), pass)];
+        ++counts[digit(bits(first[3]), pass)];
+    }
+
+    for (; first < last; ++first) {
+        ++counts[digit(bits(*first), pass)];
+    }
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::scatter(const T* first, const T* last, T* output,
+        std::size_t pass, Counts& offsets) const noexcept {
+    for (; first != last; ++first) {
+        output[offsets[digit(bits(*first), pass)]++] = *first;
+    }
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::fallback() noexcept {
+    if (m_span.size() <= THRESHOLD) {
+        insertion_sort(m_span, [this] (const T& lhs, const T& rhs) {
+            return bits(lhs) < bits(rhs);
+        });
+    }
+    else {
+        std::sort(m_span.data(), m_span.data() + m_span.size(),
+            [this] (const T& lhs, const T& rhs) {
+                return bits(lhs) < bits(rhs);
+            });
+    }
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::sort(Allocator& allocator) noexcept {
+    const auto size = m_span.size();
+
+    if (size <= THRESHOLD) {
+        fallback();
+        return;
+    }
+
+    /* Histograms of all digits followed by scratch elements */
+    auto memory = allocator.allocate((DIGITS * sizeof(Counts)) +
+            (size * sizeof(T)));
+
+    if (memory == nullptr) {
+        fallback();
+        return;
+    }
+
+    auto counts = static_cast<Counts*>(memory);
+    T* input = m_span.data();
+    T* output = reinterpret_cast<T*>(counts + DIGITS);
+
+    std::fill(&counts[0][0], &counts[0][0] + (DIGITS * RADIX), 0u);
+    histogram(input, input + size, counts);
+
+    const auto first = bits(input[0]);
+
+    for (std::size_t pass = 0; pass < DIGITS; ++pass) {
+        if (counts[pass][digit(first, pass)] != size) {
+            std::size_t offset = 0;
+
+            for (auto& count : counts[pass]) {
+                offset += std::exchange(count, offset);
+            }
+
+            scatter(input, input + size, output, pass, counts[pass]);
+            std::swap(input, output);
+        }
+    }
+
+    if (input != m_span.data()) {
+        std::memcpy(m_span.data(), input, size * sizeof(T));
+    }
+
+    allocator.deallocate(memory);
+}
+
+template<typename T, typename Key> inline void
+RadixSort<T, Key>::sort(Executor& executor) noexcept {
+    const auto size = m_span.size();
+    const auto chunks = std::min(executor.workers() * 4u, size / GRAIN);
+
+    if (chunks <= 1u) {
+        sort(executor.allocator());
+        return;
+    }
+
+    auto memory = executor.allocator().allocate((chunks * sizeof(Counts)) +
+            (size * sizeof(T)));
+
+    if (memory == nullptr) {
+        fallback();
+        return;
+    }
+
+    struct Context {
+        static void histogram(void* context, std::size_t,
+                std::size_t first, std::size_t last) noexcept {
+            auto self = static_cast<Context*>(context);
+
+            for (auto chunk = first; chunk < last; ++chunk) {
+                self->sorter->histogram(self->begin(chunk),
+                        self->begin(chunk + 1u), self->pass,
+                        self->counts[chunk]);
+            }
+        }
+
+        static void scatter(void* context, std::size_t,
+                std::size_t first, std::size_t last) noexcept {
+            auto self = static_cast<Context*>(context);
+
+            for (auto chunk = first; chunk < last; ++chunk) {
+                self->sorter->scatter(self->begin(chunk),
+                        self->begin(chunk + 1u), self->output, self->pass,
+                        self->counts[chunk]);
+            }
+        }
+
+        auto begin(std::size_t chunk) const noexcept -> const T* {
+            const auto step = size / chunks;
+            const auto extra = size % chunks;
+
+            return input + (chunk * step) + std::min(chunk, extra);
+        }
+
+        const RadixSort* sorter;
+        Counts* counts;
+        T* input;
+        T* output;
+        std::size_t size;
+        std::size_t chunks;
+        std::size_t pass;
+    } context{this, static_cast<Counts*>(memory), m_span.data(),
+        reinterpret_cast<T*>(static_cast<Counts*>(memory) + chunks),
+        size, chunks, 0u};
+
+    for (std::size_t pass = 0; pass < DIGITS; ++pass) {
+        context.pass = pass;
+        executor.run(Context::histogram, &context, chunks);
+
+        bool skip = false;
+        std::size_t offset = 0;
+
+        /* Chunk offsets of each digit follow chunk order, so it is stable */
+        for (std::size_t value = 0; (value < RADIX) && !skip; ++value) {
+            const auto start = offset;
+
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                offset += std::exchange(context.counts[chunk][value], offset);
+            }
+
+            skip = ((offset - start) == size);
+        }
+
+        if (!skip) {
+            executor.run(Context::scatter, &context, chunks);
+            std::swap(context.input, context.output);
+        }
+    }
+
+    if (context.input != m_span.data()) {
+        std::memcpy(m_span.data(), context.input, size * sizeof(T));
+    }
+
+    executor.allocator().deallocate(memory);
+}
+
+template<typename T, typename Key> inline void
+sort(Allocator& allocator, Span<T> span, Key key) noexcept {
+    RadixSort<T, Key>{span, std::move(key)}.sort(allocator);
+}
+
+template<typename T, typename Key> inline void
+sort(Executor& executor, Span<T> span, Key key) noexcept {
+    RadixSort<T, Key>{span, std::move(key)}.sort(executor);
+}
+
+template<typename T, typename Compare> inline void
+insertion_sort(Span<T> span, Compare compare) noexcept {
+    auto data = span.data();
+
+    for (std::size_t i = 1; i < span.size(); ++i) {
+        auto value = std::move(data[i]);
+        auto j = i;
+
+        for (; (j > 0) && compare(value, data[j - 1u]); --j) {
+            data[j] = std::move(data[j - 1u]);
+        }
+
+        data[j] = std::move(value);
+    }
+}
+
+template<typename T, typename Predicate> inline auto
+partition(Span<T> span, Predicate predicate) noexcept -> std::size_t {
+    constexpr std::ptrdiff_t BLOCK{64};
+
+    auto first = span.data();
+    auto last = first + span.size();
+
+    std::uint8_t left[BLOCK];
+    std::uint8_t right[BLOCK];
+    std::ptrdiff_t left_start = 0;
+    std::ptrdiff_t left_count = 0;
+    std::ptrdiff_t right_start = 0;
+    std::ptrdiff_t right_count = 0;
+
+    while ((last - first) > (2 * BLOCK)) {
+        /* Offsets of misplaced elements, written unconditionally */
+        if (left_count == 0) {
+            left_start = 0;
+
+            for (std::ptrdiff_t i = 0; i < BLOCK; ++i) {
+                left[left_count] = std::uint8_t(i);
+                left_count += !predicate(first[i]);
+            }
+        }
+
+        if (right_count == 0) {
+            right_start = 0;
+
+            for (std::ptrdiff_t i = 0; i < BLOCK; ++i) {
+                right[right_count] = std::uint8_t(i);
+                right_count += predicate(*(last - 1 - i));
+            }
+        }
+
+        const auto count = std::min(left_count, right_count);
+
+        for (std::ptrdiff_t i = 0; i < count; ++i) {
+            std::iter_swap(first + left[left_start + i],
+                    last - 1 - right[right_start + i]);
+        }
+
+        left_count -= count;
+        right_count -= count;
+        left_start += count;
+        right_start += count;
+
+        if (left_count == 0) {
+            first += BLOCK;
+        }
+
+        if (right_count == 0) {
+            last -= BLOCK;
+        }
+    }
+
+    /* Remainder holds at most two blocks, partially processed ones too */
+    const auto middle = std::partition(first, last, predicate);
+
+    return std::size_t(middle - span.data());
+}
+
+template<typename T, typename Compare> inline void
+nth_element(Span<T> span, std::size_t n, Compare compare) noexcept {
+    constexpr std::size_t SMALL{16u};
+
+    auto data = span.data();
+    std::size_t low = 0;
+    std::size_t high = span.size();
+    std::size_t depth = 0;
+
+    for (auto size = high; size > 1u; size >>= 1u) {
+        depth += 2u;
+    }
+
+    if (n >= high) {
+        return;
+    }
+
+    while ((high - low) > SMALL) {
+        if (depth-- == 0) {
+            std::nth_element(data + low, data + n, data + high, compare);
+            return;
+        }
+
+        const auto& a = data[low];
+        const auto& b = data[low + ((high - low) / 2u)];
+        const auto& c = data[high - 1u];
+
+        const T pivot = compare(a, b) ?
+            (compare(b, c) ? b : (compare(a, c) ? c : a)) :
+            (compare(a, c) ? a : (compare(b, c) ? c : b));
+
+        const auto less = low + partition(Span<T>{data + low, high - low},
+            [&] (const T& value) { return compare(value, pivot); });
+
+        if (n < less) {
+            high = less;
+            continue;
+        }
+
+        /* Pivot itself lands here, so this range is never empty */
+        const auto equal = less + partition(Span<T>{data + less, high - less},
+            [&] (const T& value) { return !compare(pivot, value); });
+
+        if (n < equal) {
+            return;
+        }
+
+        low = equal;
+    }
+
+    insertion_sort(Span<T>{data + low, high - low}, compare);
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_SORT_HPP */
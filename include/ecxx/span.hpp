@@ -25,6 +25,16 @@
 
 namespace ecxx {
 
+template<typename T>
+class Span;
+
+/* Keeps container constructors from hijacking copies between spans */
+template<typename T>
+struct IsSpan : std::false_type { };
+
+template<typename T>
+struct IsSpan<Span<T>> : std::true_type { };
+
 template<typename T>
 class Span {
 public:
@@ -56,15 +66,17 @@ public:
 
     constexpr Span(std::nullptr_t) noexcept;
 
-    template<typename U = T, typename std::enable_if<
+    template<typename U = T, typename = typename std::enable_if<
         std::is_const<U>::value>::type>
     constexpr Span(const Span<typename std::remove_const_t<U>>& other) noexcept;
 
-    template<typename U, typename = typename std::enable_if<std::is_convertible<
+    template<typename U, typename = typename std::enable_if<
+        !IsSpan<U>::value && std::is_convertible<
         typename U::pointer, pointer>::value>::type>
     constexpr Span(U& other) noexcept;
 
-    template<typename U, typename = typename std::enable_if<std::is_convertible<
+    template<typename U, typename = typename std::enable_if<
+        !IsSpan<U>::value && std::is_convertible<
         typename U::pointer, pointer>::value>::type>
     constexpr Span(const U& other) noexcept;
 
@@ -150,11 +162,10 @@ private:
 template<typename T> inline constexpr
 Span<T>::Span(std::nullptr_t) noexcept { }
 
-template<typename T> template<typename U, typename std::enable_if<
-    std::is_const<U>::value>::type> inline constexpr
+template<typename T> template<typename U, typename> inline constexpr
 Span<T>::Span(const Span<
         typename std::remove_const<U>::type>& other) noexcept :
-    m_begin{&*other.begin()}, m_end{&*other.end()}
+    m_begin{other.data()}, m_end{other.data() + other.size()}
 { }
 
 template<typename T> template<typename U, typename> inline constexpr
@@ -184,7 +195,7 @@ Span<T>::Span(value_type (&arr)[N]) noexcept :
 
 template<typename T> inline constexpr auto
 Span<T>::size() const noexcept -> size_type {
-    return m_end - m_begin;
+    return size_type(m_end - m_begin);
 }
 
 template<typename T> inline constexpr auto
@@ -255,13 +266,14 @@ Span<T>::operator[](size_type pos) const noexcept -> const_reference {
 template<typename T> inline constexpr auto
 Span<T>::first(size_type count) const noexcept -> Span {
     const auto total = size();
-    return {m_begin, m_begin + (count < total) ? count : total};
+    return {m_begin, (count < total) ? count : total};
 }
 
 template<typename T> inline constexpr auto
 Span<T>::last(size_type count) const noexcept -> Span {
     const auto total = size();
-    return {m_end - (count < total) ? count : total, m_end};
+    const auto n = (count < total) ? count : total;
+    return {m_end - n, n};
 }
 
 template<typename T> inline constexpr auto
@@ -0,0 +1,244 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_TRACE_HPP
+#define ECXX_TRACE_HPP
+
+#include "ecxx/span.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Probes are compiled only when ECXX_TRACE is defined, otherwise they and
+ * their arguments vanish. Names must be string literals, events keep only
+ * their address
+ */
+#if defined(ECXX_TRACE)
+#define ECXX_TRACE_CONCAT_(a, b) a##b
+#define ECXX_TRACE_CONCAT(a, b) ECXX_TRACE_CONCAT_(a, b)
+
+#define ECXX_TRACE_SCOPE(name) \
+    ::ecxx::trace::Scope ECXX_TRACE_CONCAT(ecxx_trace_scope_, __LINE__){name}
+
+#define ECXX_TRACE_SCOPE_PAYLOAD(name, payload) \
+    ::ecxx::trace::Scope ECXX_TRACE_CONCAT(ecxx_trace_scope_, __LINE__){ \
+        name, std::uint64_t(payload)}
+
+#define ECXX_TRACE_INSTANT(name, payload) \
+    ::ecxx::trace::instant(name, std::uint64_t(payload))
+#else
+#define ECXX_TRACE_SCOPE(name) static_cast<void>(0)
+#define ECXX_TRACE_SCOPE_PAYLOAD(name, payload) static_cast<void>(0)
+#define ECXX_TRACE_INSTANT(name, payload) static_cast<void>(0)
+#endif
+
+namespace ecxx {
+namespace trace {
+
+/* Fields are written with relaxed atomics so dump can run concurrently */
+struct Event {
+    static constexpr std::uint64_t INSTANT{~std::uint64_t(0)};
+
+    std::uint64_t timestamp;
+    /* Scope length in ticks or INSTANT */
+    std::uint64_t duration;
+    const char* name;
+    std::uint64_t payload;
+};
+
+/*
+ * Ring of events written by single thread without locks, the oldest events
+ * are overwritten. Buffer is bound to thread that constructs it and is
+ * registered for dump() until destroyed. It may be destroyed on any thread,
+ * owning thread then stops tracing into it, but probes of that thread must
+ * not be running at the time. Capacity is rounded down to a power of two
+ */
+class Buffer {
+public:
+    explicit Buffer(Span<Event> events, const char* name = nullptr) noexcept;
+
+    Buffer(Buffer&& other) noexcept = delete;
+
+    Buffer(const Buffer& other) noexcept = delete;
+
+    Buffer& operator=(Buffer&& other) noexcept = delete;
+
+    Buffer& operator=(const Buffer& other) noexcept = delete;
+
+    /* Runtime switch for all probes, they are off by default */
+    static void enable(bool value = true) noexcept;
+
+    static auto enabled() noexcept -> bool;
+
+    /* Buffer of calling thread or nullptr when tracing is off */
+    static auto current() noexcept -> Buffer*;
+
+    /* Bind buffer to calling thread, instead of thread it was bound to */
+    void attach() noexcept;
+
+    void push(std::uint64_t timestamp, std::uint64_t duration,
+            const char* name, std::uint64_t payload) noexcept;
+
+    auto capacity() const noexcept -> std::size_t;
+
+    /* Number of events written so far, including overwritten ones */
+    auto written() const noexcept -> std::uint64_t;
+
+    ~Buffer() noexcept;
+private:
+    friend auto dump(std::FILE* file) noexcept -> bool;
+
+    /* Unbinds buffer of exiting thread */
+    struct Exit;
+
+    static inline std::atomic<bool> s_enabled{false};
+    static inline thread_local std::atomic<Buffer*> s_current{nullptr};
+    static thread_local Exit s_exit;
+
+    Event* m_events{nullptr};
+    std::uint64_t m_mask{0u};
+    std::atomic<std::uint64_t> m_head{0u};
+    const char* m_name{nullptr};
+    std::uint32_t m_thread{0u};
+    /* Slot of bound thread, both are guarded by registry lock */
+    std::atomic<Buffer*>* m_owner{nullptr};
+    Buffer* m_next{nullptr};
+};
+
+/* Emits complete event with duration of its lifetime */
+class Scope {
+public:
+    explicit Scope(const char* name, std::uint64_t payload = 0) noexcept;
+
+    Scope(Scope&& other) noexcept = delete;
+
+    Scope(const Scope& other) noexcept = delete;
+
+    Scope& operator=(Scope&& other) noexcept = delete;
+
+    Scope& operator=(const Scope& other) noexcept = delete;
+
+    ~Scope() noexcept;
+private:
+    Buffer* m_buffer;
+    const char* m_name;
+    std::uint64_t m_payload;
+    std::uint64_t m_start;
+};
+
+/* Time stamp counter where available, nanoseconds otherwise */
+auto now() noexcept -> std::uint64_t;
+
+void instant(const char* name, std::uint64_t payload = 0) noexcept;
+
+/*
+ * Writes events of all registered buffers as Chrome trace event JSON that
+ * also loads into Perfetto. Events overwritten while being read are
+ * skipped. Returns false on write error
+ */
+auto dump(std::FILE* file) noexcept -> bool;
+
+inline void
+Buffer::enable(bool value) noexcept {
+    s_enabled.store(value, std::memory_order_relaxed);
+}
+
+inline auto
+Buffer::enabled() noexcept -> bool {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+inline auto
+Buffer::current() noexcept -> Buffer* {
+    return enabled() ? s_current.load(std::memory_order_relaxed) : nullptr;
+}
+
+inline auto
+Buffer::capacity() const noexcept -> std::size_t {
+    return std::size_t(m_mask) + ((m_events != nullptr) ? 1u : 0u);
+}
+
+inline auto
+Buffer::written() const noexcept -> std::uint64_t {
+    return m_head.load(std::memory_order_acquire);
+}
+
+inline void
+Buffer::push(std::uint64_t timestamp, std::uint64_t duration,
+        const char* name, std::uint64_t payload) noexcept {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    auto& event = m_events[head & m_mask];
+
+    /*
+     * Reader that sees any of the stores below must also see head, pairs
+     * with acquire fence in dump() like seqlock writer
+     */
+    std::atomic_thread_fence(std::memory_order_release);
+
+    __atomic_store_n(&event.timestamp, timestamp, __ATOMIC_RELAXED);
+    __atomic_store_n(&event.duration, duration, __ATOMIC_RELAXED);
+    __atomic_store_n(&event.name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&event.payload, payload, __ATOMIC_RELAXED);
+
+    m_head.store(head + 1u, std::memory_order_release);
+}
+
+inline auto
+now() noexcept -> std::uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline void
+instant(const char* name, std::uint64_t payload) noexcept {
+    auto buffer = Buffer::current();
+
+    if (buffer != nullptr) {
+        buffer->push(now(), Event::INSTANT, name, payload);
+    }
+}
+
+inline
+Scope::Scope(const char* name, std::uint64_t payload) noexcept :
+    m_buffer{Buffer::current()},
+    m_name{name},
+    m_payload{payload},
+    m_start{(m_buffer != nullptr) ? now() : 0u}
+{ }
+
+inline
+Scope::~Scope() noexcept {
+    if (m_buffer != nullptr) {
+        m_buffer->push(m_start, now() - m_start, m_name, m_payload);
+    }
+}
+
+} /* namespace trace */
+} /* namespace ecxx */
+
+#endif /* ECXX_TRACE_HPP */
@@ -0,0 +1,290 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_UNIQUE_PTR_HPP
+#define ECXX_UNIQUE_PTR_HPP
+
+#include "ecxx/allocator.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace ecxx {
+
+/*
+ * Deleter that returns object to allocator that created it
+ */
+class AllocatorDelete {
+public:
+    constexpr AllocatorDelete() noexcept = default;
+
+    constexpr AllocatorDelete(Allocator& allocator) noexcept;
+
+    constexpr auto allocator() const noexcept -> Allocator*;
+
+    template<typename T>
+    void operator()(T* ptr) const noexcept;
+private:
+    Allocator* m_allocator{nullptr};
+};
+
+/*
+ * Single owner of object. Deleter must be class type, stateless deleters
+ * take no space. Default deleter keeps pointer to allocator so object can
+ * be released without knowing where it came from
+ */
+template<typename T, typename Deleter = AllocatorDelete>
+class UniquePtr : private Deleter {
+public:
+    using element_type = T;
+
+    using pointer = T*;
+
+    using deleter_type = Deleter;
+
+    constexpr UniquePtr() noexcept = default;
+
+    constexpr UniquePtr(std::nullptr_t) noexcept;
+
+    /*
+     * Only for deleters that need no state, default deleter would not know
+     * allocator and object would leak. Pass allocator as deleter instead
+     */
+    template<typename D = Deleter, typename = std::enable_if_t<
+        !std::is_same<D, AllocatorDelete>::value>>
+    explicit UniquePtr(T* ptr) noexcept;
+
+    UniquePtr(T* ptr, const Deleter& deleter) noexcept;
+
+    UniquePtr(UniquePtr&& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    UniquePtr(UniquePtr<U, Deleter>&& other) noexcept;
+
+    UniquePtr(const UniquePtr& other) = delete;
+
+    UniquePtr& operator=(UniquePtr&& other) noexcept;
+
+    template<typename U, typename = std::enable_if_t<
+        std::is_convertible<U*, T*>::value>>
+    UniquePtr& operator=(UniquePtr<U, Deleter>&& other) noexcept;
+
+    UniquePtr& operator=(const UniquePtr& other) = delete;
+
+    UniquePtr& operator=(std::nullptr_t) noexcept;
+
+    auto get() const noexcept -> T*;
+
+    auto get_deleter() noexcept -> Deleter&;
+
+    auto get_deleter() const noexcept -> const Deleter&;
+
+    /* Gives up ownership without destroying object */
+    auto release() noexcept -> T*;
+
+    void reset(T* ptr = nullptr) noexcept;
+
+    void swap(UniquePtr& other) noexcept;
+
+    auto operator*() const noexcept -> T&;
+
+    auto operator->() const noexcept -> T*;
+
+    explicit operator bool() const noexcept;
+
+    ~UniquePtr() noexcept;
+private:
+    template<typename U, typename D>
+    friend class UniquePtr;
+
+    T* m_pointer{nullptr};
+};
+
+/*
+ * Constructs object in memory from allocator. Returned pointer is empty
+ * when allocation fails
+ */
+template<typename T, typename... Args>
+auto allocate_unique(Allocator& allocator,
+        Args&&... args) noexcept -> UniquePtr<T>;
+
+inline constexpr
+AllocatorDelete::AllocatorDelete(Allocator& allocator) noexcept :
+    m_allocator{&allocator}
+{ }
+
+inline constexpr auto
+AllocatorDelete::allocator() const noexcept -> Allocator* {
+    return m_allocator;
+}
+
+template<typename T> inline void
+AllocatorDelete::operator()(T* ptr) const noexcept {
+    if (m_allocator != nullptr) {
+        m_allocator->destroy(ptr);
+    }
+}
+
+template<typename T, typename Deleter> inline constexpr
+UniquePtr<T, Deleter>::UniquePtr(std::nullptr_t) noexcept :
+    Deleter{},
+    m_pointer{nullptr}
+{ }
+
+template<typename T, typename Deleter>
+template<typename D, typename> inline
+UniquePtr<T, Deleter>::UniquePtr(T* ptr) noexcept :
+    Deleter{},
+    m_pointer{ptr}
+{ }
+
+template<typename T, typename Deleter> inline
+UniquePtr<T, Deleter>::UniquePtr(T* ptr, const Deleter& deleter) noexcept :
+    Deleter{deleter},
+    m_pointer{ptr}
+{ }
+
+template<typename T, typename Deleter> inline
+UniquePtr<T, Deleter>::UniquePtr(UniquePtr&& other) noexcept :
+    Deleter{std::move(other.get_deleter())},
+    m_pointer{other.release()}
+{ }
+
+template<typename T, typename Deleter>
+template<typename U, typename> inline
+UniquePtr<T, Deleter>::UniquePtr(UniquePtr<U, Deleter>&& other) noexcept :
+    Deleter{std::move(other.get_deleter())},
+    m_pointer{other.release()}
+{ }
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::operator=(UniquePtr&& other) noexcept -> UniquePtr& {
+    if (this != &other) {
+        reset(other.release());
+        get_deleter() = std::move(other.get_deleter());
+    }
+    return *this;
+}
+
+template<typename T, typename Deleter>
+template<typename U, typename> inline auto
+UniquePtr<T, Deleter>::operator=(
+        UniquePtr<U, Deleter>&& other) noexcept -> UniquePtr& {
+    reset(other.release());
+    get_deleter() = std::move(other.get_deleter());
+    return *this;
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::operator=(std::nullptr_t) noexcept -> UniquePtr& {
+    reset();
+    return *this;
+}
+
+template<typename T, typename Deleter> inline
+UniquePtr<T, Deleter>::~UniquePtr() noexcept {
+    reset();
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::get() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::get_deleter() noexcept -> Deleter& {
+    return *this;
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::get_deleter() const noexcept -> const Deleter& {
+    return *this;
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::release() noexcept -> T* {
+    auto ptr = m_pointer;
+    m_pointer = nullptr;
+    return ptr;
+}
+
+template<typename T, typename Deleter> inline void
+UniquePtr<T, Deleter>::reset(T* ptr) noexcept {
+    auto old = m_pointer;
+    m_pointer = ptr;
+
+    if (old != nullptr) {
+        get_deleter()(old);
+    }
+}
+
+template<typename T, typename Deleter> inline void
+UniquePtr<T, Deleter>::swap(UniquePtr& other) noexcept {
+    using std::swap;
+
+    swap(get_deleter(), other.get_deleter());
+    swap(m_pointer, other.m_pointer);
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::operator*() const noexcept -> T& {
+    return *m_pointer;
+}
+
+template<typename T, typename Deleter> inline auto
+UniquePtr<T, Deleter>::operator->() const noexcept -> T* {
+    return m_pointer;
+}
+
+template<typename T, typename Deleter> inline
+UniquePtr<T, Deleter>::operator bool() const noexcept {
+    return m_pointer != nullptr;
+}
+
+template<typename T, typename... Args> inline auto
+allocate_unique(Allocator& allocator,
+        Args&&... args) noexcept -> UniquePtr<T> {
+    return UniquePtr<T>{allocator.construct<T>(std::forward<Args>(args)...),
+        allocator};
+}
+
+template<typename T, typename D> static inline auto
+operator==(const UniquePtr<T, D>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() == nullptr;
+}
+
+template<typename T, typename D> static inline auto
+operator!=(const UniquePtr<T, D>& ptr, std::nullptr_t) noexcept -> bool {
+    return ptr.get() != nullptr;
+}
+
+template<typename T, typename U, typename D> static inline auto
+operator==(const UniquePtr<T, D>& lhs,
+        const UniquePtr<U, D>& rhs) noexcept -> bool {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U, typename D> static inline auto
+operator!=(const UniquePtr<T, D>& lhs,
+        const UniquePtr<U, D>& rhs) noexcept -> bool {
+    return lhs.get() != rhs.get();
+}
+
+} /* namespace ecxx */
+
+#endif /* ECXX_UNIQUE_PTR_HPP */
@@ -14,9 +14,13 @@
  */
 
 #include "ecxx/allocator/pool.hpp"
+#include "ecxx/trace.hpp"
 
 #include <cstddef>
+#include <cstring>
+#include <utility>
 #include <algorithm>
+#include <functional>
 
 using ecxx::allocator::Pool;
 
@@ -25,81 +29,257 @@ struct Header {
     std::size_t size;
 };
 
+/* Gap between two neighbour headers, next is nullptr for the memory end */
+struct Cursor {
+    Header* prev;
+    Header* next;
+};
+
 static constexpr std::uintptr_t HEADER_ALIGN =
     std::max(alignof(Header), alignof(std::max_align_t));
 
 static constexpr std::uintptr_t HEADER_OFFSET = HEADER_ALIGN - 1u;
-static constexpr std::uintptr_t HEADER_MASK = ~HEADER_ALIGN;
+static constexpr std::uintptr_t HEADER_MASK = ~HEADER_OFFSET;
 
 static constexpr inline
 auto align(std::uintptr_t address) noexcept -> std::uintptr_t {
     return (address + sizeof(Header) + HEADER_OFFSET) & HEADER_MASK;
 }
 
-auto Pool::allocate(std::size_t n) noexcept -> void* {
-    void* ptr = nullptr;
+static inline
+auto header_of(std::uintptr_t address) noexcept -> Header* {
+    return reinterpret_cast<Header*>(address - sizeof(Header));
+}
 
-    if (n != 0) {
-        auto header = static_cast<Header*>(m_header_first);
-        auto address_end = m_memory_end;
-        auto address = m_memory_begin;
+static inline
+auto data_end(const Header* header) noexcept -> std::uintptr_t {
+    return std::uintptr_t(header) + sizeof(Header) + header->size;
+}
 
-        do {
-            address = align(address);
+/* Moves cursor to the first gap that fits n bytes, returns 0 if none */
+static inline
+auto fit(Cursor& cursor, std::uintptr_t memory_begin,
+        std::uintptr_t memory_end, std::size_t n) noexcept -> std::uintptr_t {
+    std::uintptr_t address = 0;
 
-            if ((address + n) <= address_end) {
-                ptr = reinterpret_cast<void*>(address);
+    for (;;) {
+        const auto begin = align((cursor.prev != nullptr) ?
+                data_end(cursor.prev) : memory_begin);
 
-                auto hdr = reinterpret_cast<Header*>(
-                        address - sizeof(Header));
+        const auto end = (cursor.next != nullptr) ?
+            std::uintptr_t(cursor.next) : memory_end;
 
-                hdr->size = n;
+        if ((begin <= end) && (n <= (end - begin))) {
+            address = begin;
+            break;
+        }
 
-                if (header != nullptr) {
-                    hdr->next = header->next;
-                    header->next = hdr;
-                }
+        if (cursor.next == nullptr) {
+            break;
+        }
 
-                if (m_header_first == header) {
-                    m_header_first = hdr;
-                }
-                else {
-                    reinterpret_cast<Header*>(address_end)->next = hdr;
-                }
-            }
-            else if (header != nullptr) {
-                auto address = align((header != nullptr) ? (std::uintptr_t(header) +
-                        sizeof(Header) + header->size) : m_memory_begin);
+        cursor.prev = cursor.next;
+        cursor.next = cursor.next->next;
+    }
 
+    return address;
+}
 
+static inline
+void link(void*& first, void*& last, Cursor& cursor,
+        std::uintptr_t address, std::size_t n) noexcept {
+    auto header = header_of(address);
 
-                address_end = std::uintptr_t(header);
-                header = header->prev;
-            }
-        } while ((ptr == nullptr) && (header != nullptr));
+    header->next = cursor.next;
+    header->size = n;
+
+    if (cursor.prev != nullptr) {
+        cursor.prev->next = header;
+    }
+    else {
+        first = header;
     }
 
-    return ptr;
+    if (cursor.next == nullptr) {
+        last = header;
+    }
+
+    cursor.prev = header;
 }
 
-auto Pool::reallocate(void* src, std::size_t n) noexcept -> void* {
+static inline
+void unlink(void*& first, void*& last, Header* prev, Header* header) noexcept {
+    if (prev != nullptr) {
+        prev->next = header->next;
+    }
+    else {
+        first = header->next;
+    }
+
+    if (last == header) {
+        last = prev;
+    }
+}
+
+Pool::Pool(Pool&& other) noexcept :
+    m_memory_begin{std::exchange(other.m_memory_begin, 0u)},
+    m_memory_end{std::exchange(other.m_memory_end, 0u)},
+    m_header_first{std::exchange(other.m_header_first, nullptr)},
+    m_header_last{std::exchange(other.m_header_last, nullptr)}
+{ }
+
+Pool& Pool::operator=(Pool&& other) noexcept {
+    if (this != &other) {
+        m_memory_begin = std::exchange(other.m_memory_begin, 0u);
+        m_memory_end = std::exchange(other.m_memory_end, 0u);
+        m_header_first = std::exchange(other.m_header_first, nullptr);
+        m_header_last = std::exchange(other.m_header_last, nullptr);
+    }
+
+    return *this;
+}
+
+auto Pool::allocate(std::size_t n) noexcept -> void* {
+    ECXX_TRACE_SCOPE_PAYLOAD("Pool::allocate", n);
+
     void* ptr = nullptr;
 
     if (n != 0) {
-        if (ptr != nullptr) {
+        /* Try the gap after the last block first, it is usually the largest */
+        Cursor cursor{static_cast<Header*>(m_header_last), nullptr};
+        auto address = fit(cursor, m_memory_begin, m_memory_end, n);
+
+        if ((address == 0) && (m_header_first != nullptr)) {
+            cursor = {nullptr, static_cast<Header*>(m_header_first)};
+            address = fit(cursor, m_memory_begin, m_memory_end, n);
+        }
 
+        if (address != 0) {
+            link(m_header_first, m_header_last, cursor, address, n);
+            ptr = reinterpret_cast<void*>(address);
         }
         else {
-            ptr = allocate(n);
+            ECXX_TRACE_INSTANT("Pool::allocate failed", n);
         }
     }
+
+    return ptr;
+}
+
+auto Pool::reallocate(void* src, std::size_t n) noexcept -> void* {
+    void* ptr = nullptr;
+
+    if (src == nullptr) {
+        ptr = allocate(n);
+    }
+    else if (n == 0) {
+        deallocate(src);
+    }
     else {
-        deallocate(ptr);
+        auto header = header_of(std::uintptr_t(src));
+
+        const auto end = (header->next != nullptr) ?
+            std::uintptr_t(header->next) : m_memory_end;
+
+        if (n <= (end - std::uintptr_t(src))) {
+            header->size = n;
+            ptr = src;
+        }
+        else {
+            ptr = allocate(n);
+
+            if (ptr != nullptr) {
+                std::memcpy(ptr, src, std::min(header->size, n));
+                deallocate(src);
+            }
+        }
     }
 
     return ptr;
 }
 
 void Pool::deallocate(void* ptr) noexcept {
-    return std::free(ptr);
+    ECXX_TRACE_SCOPE_PAYLOAD("Pool::deallocate", std::uintptr_t(ptr));
+
+    const auto address = std::uintptr_t(ptr);
+
+    if ((address > m_memory_begin) && (address < m_memory_end)) {
+        const auto target = header_of(address);
+
+        Header* prev = nullptr;
+        auto header = static_cast<Header*>(m_header_first);
+
+        /* Headers are sorted by address */
+        while ((header != nullptr) &&
+                (std::uintptr_t(header) < std::uintptr_t(target))) {
+            prev = header;
+            header = header->next;
+        }
+
+        if (header == target) {
+            unlink(m_header_first, m_header_last, prev, header);
+        }
+    }
+}
+
+auto Pool::allocate_bulk(std::size_t n, std::size_t count,
+        Span<void*> out) noexcept -> std::size_t {
+    if (count > out.size()) {
+        count = out.size();
+    }
+
+    std::size_t allocated = 0;
+
+    if (n != 0) {
+        Cursor cursor{static_cast<Header*>(m_header_last), nullptr};
+        bool rewound = (m_header_first == nullptr);
+
+        while (allocated < count) {
+            const auto address = fit(cursor, m_memory_begin, m_memory_end, n);
+
+            if (address != 0) {
+                link(m_header_first, m_header_last, cursor, address, n);
+                out[allocated++] = reinterpret_cast<void*>(address);
+            }
+            else if (!rewound) {
+                cursor = {nullptr, static_cast<Header*>(m_header_first)};
+                rewound = true;
+            }
+            else {
+                break;
+            }
+        }
+    }
+
+    for (auto i = allocated; i < out.size(); ++i) {
+        out[i] = nullptr;
+    }
+
+    return allocated;
+}
+
+void Pool::deallocate_bulk(Span<void*> ptrs) noexcept {
+    std::sort(ptrs.data(), ptrs.data() + ptrs.size(), std::less<void*>{});
+
+    Header* prev = nullptr;
+    auto header = static_cast<Header*>(m_header_first);
+
+    for (auto ptr : ptrs) {
+        const auto address = std::uintptr_t(ptr);
+
+        if ((address > m_memory_begin) && (address < m_memory_end)) {
+            const auto target = header_of(address);
+
+            while ((header != nullptr) &&
+                    (std::uintptr_t(header) < std::uintptr_t(target))) {
+                prev = header;
+                header = header->next;
+            }
+
+            if (header == target) {
+                unlink(m_header_first, m_header_last, prev, header);
+                header = header->next;
+            }
+        }
+    }
 }
@@ -0,0 +1,175 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ecxx/allocator/recorder.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+using ecxx::allocator::Recorder;
+
+/* Hidden block prefix with lifetime id, keeps user data aligned */
+static constexpr std::size_t PREFIX{alignof(std::max_align_t)};
+
+static inline
+auto now() noexcept -> std::uint64_t {
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static inline
+auto thread_index() noexcept -> std::uint16_t {
+    static std::atomic<std::uint16_t> g_threads{0u};
+    thread_local const auto index =
+        g_threads.fetch_add(1u, std::memory_order_relaxed);
+    return index;
+}
+
+static inline
+auto prefix_of(void* ptr) noexcept -> std::uint32_t* {
+    return reinterpret_cast<std::uint32_t*>(std::uintptr_t(ptr) - PREFIX);
+}
+
+Recorder::Recorder(Allocator& upstream, Span<Event> buffer,
+        std::FILE* file) noexcept :
+    m_upstream{upstream},
+    m_buffer{buffer},
+    m_file{file},
+    m_start{now()}
+{
+    if (m_file != nullptr) {
+        FileHeader header{};
+
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.event_size = sizeof(Event);
+
+        std::fwrite(&header, sizeof(header), 1, m_file);
+    }
+}
+
+Recorder::~Recorder() noexcept {
+    flush();
+}
+
+auto Recorder::allocate(std::size_t n) noexcept -> void* {
+    void* ptr = nullptr;
+
+    if (n != 0) {
+        auto memory = m_upstream.allocate(n + PREFIX);
+
+        if (memory != nullptr) {
+            const auto id = m_id.fetch_add(1u, std::memory_order_relaxed);
+
+            ptr = reinterpret_cast<void*>(std::uintptr_t(memory) + PREFIX);
+            *prefix_of(ptr) = id;
+
+            record(Type::ALLOCATE, id, n);
+        }
+    }
+
+    return ptr;
+}
+
+auto Recorder::reallocate(void* ptr, std::size_t n) noexcept -> void* {
+    void* result = nullptr;
+
+    if (ptr == nullptr) {
+        result = allocate(n);
+    }
+    else if (n == 0) {
+        deallocate(ptr);
+    }
+    else {
+        const auto id = *prefix_of(ptr);
+        auto memory = m_upstream.reallocate(prefix_of(ptr), n + PREFIX);
+
+        if (memory != nullptr) {
+            result = reinterpret_cast<void*>(std::uintptr_t(memory) + PREFIX);
+            record(Type::REALLOCATE, id, n);
+        }
+    }
+
+    return result;
+}
+
+void Recorder::deallocate(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        const auto id = *prefix_of(ptr);
+
+        m_upstream.deallocate(prefix_of(ptr));
+        record(Type::DEALLOCATE, id, 0);
+    }
+}
+
+auto Recorder::events(Span<Event> out) noexcept -> std::size_t {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    const auto count = std::min(m_count, out.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = m_buffer[(m_head + i) % m_buffer.size()];
+    }
+
+    return count;
+}
+
+void Recorder::flush() noexcept {
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    if (m_file != nullptr) {
+        write();
+        std::fflush(m_file);
+    }
+}
+
+void Recorder::record(Type type, std::uint32_t id, std::size_t size) noexcept {
+    const Event event{now() - m_start, size, id, thread_index(), type, 0u};
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+
+    const auto capacity = m_buffer.size();
+
+    if (capacity == 0) {
+        m_dropped.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+
+    if (m_count == capacity) {
+        if (m_file != nullptr) {
+            write();
+        }
+        else {
+            m_head = (m_head + 1u) % capacity;
+            --m_count;
+            m_dropped.fetch_add(1u, std::memory_order_relaxed);
+        }
+    }
+
+    m_buffer[(m_head + m_count) % capacity] = event;
+    ++m_count;
+}
+
+void Recorder::write() noexcept {
+    const auto capacity = m_buffer.size();
+    const auto tail = std::min(m_count, capacity - m_head);
+
+    std::fwrite(m_buffer.data() + m_head, sizeof(Event), tail, m_file);
+    std::fwrite(m_buffer.data(), sizeof(Event), m_count - tail, m_file);
+
+    m_head = 0;
+    m_count = 0;
+}
@@ -0,0 +1,303 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ecxx/allocator/small_object.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+using ecxx::allocator::SmallObject;
+
+struct Run {
+    Run* prev;
+    Run* next;
+    void* free;
+    std::uint32_t used;
+    std::uint32_t next_block;
+    std::size_t size_class;
+};
+
+struct ClassTable {
+    std::uint8_t index[(SmallObject::MAX_SIZE / 8u) + 1u];
+};
+
+static constexpr std::size_t CLASS_SIZES[SmallObject::CLASSES]{
+    8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+    320, 384, 448, 512, 640, 768, 896, 1024
+};
+
+static_assert(CLASS_SIZES[SmallObject::CLASSES - 1u] == SmallObject::MAX_SIZE,
+        "The last size class must cover the maximum size");
+
+static constexpr std::uintptr_t RUN_MASK = ~(SmallObject::RUN_SIZE - 1u);
+
+static constexpr std::uint32_t RUN_BLOCKS = std::uint32_t(
+    (sizeof(Run) + alignof(std::max_align_t) - 1u) &
+    ~(alignof(std::max_align_t) - 1u));
+
+static constexpr inline
+auto make_class_table() noexcept -> ClassTable {
+    ClassTable table{};
+    std::size_t size_class = 0;
+
+    for (std::size_t i = 0; i < sizeof(table.index); ++i) {
+        while (CLASS_SIZES[size_class] < (i * 8u)) {
+            ++size_class;
+        }
+
+        table.index[i] = std::uint8_t(size_class);
+    }
+
+    return table;
+}
+
+/* Maps request size in 8 bytes granules to size class */
+static constexpr ClassTable CLASS_TABLE = make_class_table();
+
+static constexpr inline
+auto class_of(std::size_t n) noexcept -> std::size_t {
+    return CLASS_TABLE.index[(n + 7u) >> 3u];
+}
+
+static inline
+auto run_of(const void* ptr) noexcept -> Run* {
+    return reinterpret_cast<Run*>(std::uintptr_t(ptr) & RUN_MASK);
+}
+
+static inline
+auto full(const Run* run) noexcept -> bool {
+    return (run->free == nullptr) && ((run->next_block +
+        CLASS_SIZES[run->size_class]) > SmallObject::RUN_SIZE);
+}
+
+/* Takes block from run that is always the head of its class list */
+static inline
+auto pop(void*& head, Run* run) noexcept -> void* {
+    void* ptr = run->free;
+
+    if (ptr != nullptr) {
+        run->free = *static_cast<void**>(ptr);
+    }
+    else {
+        ptr = reinterpret_cast<void*>(std::uintptr_t(run) + run->next_block);
+        run->next_block += std::uint32_t(CLASS_SIZES[run->size_class]);
+    }
+
+    ++run->used;
+
+    if (full(run)) {
+        head = run->next;
+
+        if (run->next != nullptr) {
+            run->next->prev = nullptr;
+        }
+
+        run->next = nullptr;
+    }
+
+    return ptr;
+}
+
+SmallObject::SmallObject(void* memory, std::size_t size,
+        Allocator& upstream) noexcept :
+    m_upstream{upstream}
+{
+    const auto begin = (std::uintptr_t(memory) + RUN_SIZE - 1u) & RUN_MASK;
+    const auto end = (std::uintptr_t(memory) + size) & RUN_MASK;
+
+    if (begin < end) {
+        m_memory_begin = begin;
+        m_memory_end = end;
+        m_memory_next = begin;
+    }
+}
+
+auto SmallObject::run(std::size_t index) noexcept -> void* {
+    auto run = static_cast<Run*>(m_runs[index]);
+
+    if (run == nullptr) {
+        run = static_cast<Run*>(m_runs_free);
+
+        if (run != nullptr) {
+            m_runs_free = run->next;
+        }
+        else if (m_memory_next < m_memory_end) {
+            run = reinterpret_cast<Run*>(m_memory_next);
+            m_memory_next += RUN_SIZE;
+        }
+
+        if (run != nullptr) {
+            run->prev = nullptr;
+            run->next = nullptr;
+            run->free = nullptr;
+            run->used = 0;
+            run->next_block = RUN_BLOCKS;
+            run->size_class = index;
+            m_runs[index] = run;
+        }
+    }
+
+    return run;
+}
+
+void SmallObject::release(void* ptr) noexcept {
+    auto run = run_of(ptr);
+    auto& head = m_runs[run->size_class];
+    const auto was_full = full(run);
+
+    *static_cast<void**>(ptr) = run->free;
+    run->free = ptr;
+    --run->used;
+
+    if (was_full) {
+        run->next = static_cast<Run*>(head);
+
+        if (run->next != nullptr) {
+            run->next->prev = run;
+        }
+
+        head = run;
+    }
+
+    /* Keep the last run of class to avoid thrashing on alloc/free pairs */
+    if ((run->used == 0) && ((head != run) || (run->next != nullptr))) {
+        if (run->prev != nullptr) {
+            run->prev->next = run->next;
+        }
+        else {
+            head = run->next;
+        }
+
+        if (run->next != nullptr) {
+            run->next->prev = run->prev;
+        }
+
+        run->next = static_cast<Run*>(m_runs_free);
+        m_runs_free = run;
+    }
+}
+
+auto SmallObject::allocate(std::size_t n) noexcept -> void* {
+    void* ptr = nullptr;
+
+    if (n != 0) {
+        if (n <= MAX_SIZE) {
+            const auto index = class_of(n);
+            auto block_run = static_cast<Run*>(run(index));
+
+            if (block_run != nullptr) {
+                ptr = pop(m_runs[index], block_run);
+            }
+        }
+
+        if (ptr == nullptr) {
+            ptr = m_upstream.allocate(n);
+        }
+    }
+
+    return ptr;
+}
+
+auto SmallObject::reallocate(void* ptr, std::size_t n) noexcept -> void* {
+    void* result = nullptr;
+
+    if (ptr == nullptr) {
+        result = allocate(n);
+    }
+    else if (n == 0) {
+        deallocate(ptr);
+    }
+    else if (!owns(ptr)) {
+        result = m_upstream.reallocate(ptr, n);
+    }
+    else {
+        const auto size = CLASS_SIZES[run_of(ptr)->size_class];
+
+        if (n <= size) {
+            result = ptr;
+        }
+        else {
+            result = allocate(n);
+
+            if (result != nullptr) {
+                std::memcpy(result, ptr, size);
+                release(ptr);
+            }
+        }
+    }
+
+    return result;
+}
+
+void SmallObject::deallocate(void* ptr) noexcept {
+    if (owns(ptr)) {
+        release(ptr);
+    }
+    else if (ptr != nullptr) {
+        m_upstream.deallocate(ptr);
+    }
+}
+
+auto SmallObject::allocate_bulk(std::size_t n, std::size_t count,
+        Span<void*> out) noexcept -> std::size_t {
+    if (count > out.size()) {
+        count = out.size();
+    }
+
+    std::size_t allocated = 0;
+
+    if ((n != 0) && (n <= MAX_SIZE)) {
+        const auto index = class_of(n);
+
+        while (allocated < count) {
+            auto block_run = static_cast<Run*>(run(index));
+
+            if (block_run == nullptr) {
+                break;
+            }
+
+            out[allocated++] = pop(m_runs[index], block_run);
+        }
+    }
+
+    if (n != 0) {
+        allocated += m_upstream.allocate_bulk(n, count - allocated,
+                out.subspan(allocated));
+    }
+    else {
+        for (auto& ptr : out) {
+            ptr = nullptr;
+        }
+    }
+
+    return allocated;
+}
+
+void SmallObject::deallocate_bulk(Span<void*> ptrs) noexcept {
+    auto first = ptrs.data();
+    auto last = ptrs.data() + ptrs.size();
+
+    auto middle = std::partition(first, last,
+        [this] (const void* ptr) { return owns(ptr); });
+
+    for (auto it = first; it != middle; ++it) {
+        release(*it);
+    }
+
+    if (middle != last) {
+        m_upstream.deallocate_bulk(ptrs.subspan(std::size_t(middle - first)));
+    }
+}
@@ -0,0 +1,299 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ecxx/bit_span.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using ecxx::BitSpan;
+
+using word_type = BitSpan::word_type;
+using size_type = BitSpan::size_type;
+
+static constexpr size_type WORD_BITS{BitSpan::WORD_BITS};
+static constexpr word_type ONES{~word_type(0)};
+
+#if defined(__AVX2__)
+static constexpr size_type VECTOR_WORDS{sizeof(__m256i) / sizeof(word_type)};
+
+static inline
+auto load(const word_type* words) noexcept -> __m256i {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+}
+
+static inline
+void store(word_type* words, __m256i value) noexcept {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), value);
+}
+#endif
+
+struct And {
+    static auto scalar(word_type a, word_type b) noexcept -> word_type {
+        return a & b;
+    }
+
+#if defined(__AVX2__)
+    static auto vector(__m256i a, __m256i b) noexcept -> __m256i {
+        return _mm256_and_si256(a, b);
+    }
+#endif
+};
+
+struct Or {
+    static auto scalar(word_type a, word_type b) noexcept -> word_type {
+        return a | b;
+    }
+
+#if defined(__AVX2__)
+    static auto vector(__m256i a, __m256i b) noexcept -> __m256i {
+        return _mm256_or_si256(a, b);
+    }
+#endif
+};
+
+struct Xor {
+    static auto scalar(word_type a, word_type b) noexcept -> word_type {
+        return a ^ b;
+    }
+
+#if defined(__AVX2__)
+    static auto vector(__m256i a, __m256i b) noexcept -> __m256i {
+        return _mm256_xor_si256(a, b);
+    }
+#endif
+};
+
+struct AndNot {
+    static auto scalar(word_type a, word_type b) noexcept -> word_type {
+        return a & ~b;
+    }
+
+#if defined(__AVX2__)
+    static auto vector(__m256i a, __m256i b) noexcept -> __m256i {
+        return _mm256_andnot_si256(b, a);
+    }
+#endif
+};
+
+static inline
+auto popcount(word_type word) noexcept -> size_type {
+    return size_type(__builtin_popcountll(word));
+}
+
+static inline
+auto ctz(word_type word) noexcept -> size_type {
+    return size_type(__builtin_ctzll(word));
+}
+
+static inline
+auto words_of(size_type bits) noexcept -> size_type {
+    return (bits + WORD_BITS - 1u) / WORD_BITS;
+}
+
+static auto popcount(const word_type* words, size_type n) noexcept -> size_type {
+    size_type total = 0;
+    size_type i = 0;
+
+#if defined(__AVX2__)
+    /* Nibble lookup with vpshufb, sums bytes with vpsadbw */
+    const auto lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto low = _mm256_set1_epi8(0x0F);
+    auto sum = _mm256_setzero_si256();
+
+    for (; (i + VECTOR_WORDS) <= n; i += VECTOR_WORDS) {
+        const auto v = load(words + i);
+        const auto lo = _mm256_and_si256(v, low);
+        const auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+        const auto bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                _mm256_shuffle_epi8(lookup, hi));
+
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(bytes,
+                    _mm256_setzero_si256()));
+    }
+
+    total += size_type(_mm256_extract_epi64(sum, 0)) +
+        size_type(_mm256_extract_epi64(sum, 1)) +
+        size_type(_mm256_extract_epi64(sum, 2)) +
+        size_type(_mm256_extract_epi64(sum, 3));
+#endif
+
+    for (; i < n; ++i) {
+        total += popcount(words[i]);
+    }
+
+    return total;
+}
+
+/* Finds the first bit equal to !Invert at or after pos */
+template<bool Invert>
+static auto find(const word_type* words, size_type size,
+        size_type pos) noexcept -> size_type {
+    constexpr word_type flip = Invert ? ONES : 0u;
+
+    if (pos >= size) {
+        return BitSpan::npos;
+    }
+
+    const auto count = words_of(size);
+    auto index = pos / WORD_BITS;
+    auto word = (words[index] ^ flip) & (ONES << (pos % WORD_BITS));
+
+    while (word == 0) {
+        ++index;
+
+#if defined(__AVX2__)
+        /* Skips blocks of words without a candidate bit */
+        for (; (index + VECTOR_WORDS) <= count; index += VECTOR_WORDS) {
+            const auto v = load(words + index);
+
+            const bool skip = Invert ?
+                (_mm256_testc_si256(v, _mm256_set1_epi64x(-1)) != 0) :
+                (_mm256_testz_si256(v, v) != 0);
+
+            if (!skip) {
+                break;
+            }
+        }
+#endif
+
+        if (index >= count) {
+            return BitSpan::npos;
+        }
+
+        word = words[index] ^ flip;
+    }
+
+    const auto result = (index * WORD_BITS) + ctz(word);
+
+    return (result < size) ? result : BitSpan::npos;
+}
+
+static void fill(word_type* words, size_type first, size_type last,
+        bool value) noexcept {
+    if (first >= last) {
+        return;
+    }
+
+    const auto head_index = first / WORD_BITS;
+    const auto tail_index = (last - 1u) / WORD_BITS;
+    const auto head = ONES << (first % WORD_BITS);
+    const auto tail = ONES >> ((WORD_BITS - 1u) - ((last - 1u) % WORD_BITS));
+
+    auto apply = [value] (word_type& word, word_type mask) {
+        word = value ? (word | mask) : (word & ~mask);
+    };
+
+    if (head_index == tail_index) {
+        apply(words[head_index], head & tail);
+    }
+    else {
+        apply(words[head_index], head);
+        std::fill(words + head_index + 1u, words + tail_index,
+                value ? ONES : word_type(0));
+        apply(words[tail_index], tail);
+    }
+}
+
+/* Combines first bits of dst with src, bits at or above bits stay intact */
+template<typename Operation>
+static void combine(word_type* dst, const word_type* src,
+        size_type bits) noexcept {
+    const auto n = bits / WORD_BITS;
+    size_type i = 0;
+
+#if defined(__AVX2__)
+    for (; (i + VECTOR_WORDS) <= n; i += VECTOR_WORDS) {
+        store(dst + i, Operation::vector(load(dst + i), load(src + i)));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[i] = Operation::scalar(dst[i], src[i]);
+    }
+
+    if ((bits % WORD_BITS) != 0) {
+        const auto mask = ONES >> (WORD_BITS - (bits % WORD_BITS));
+
+        dst[n] = (dst[n] & ~mask) | (Operation::scalar(dst[n], src[n]) & mask);
+    }
+}
+
+void BitSpan::set(size_type first, size_type count) noexcept {
+    if (first < m_size) {
+        fill(m_words.data(), first, first + std::min(count, m_size - first),
+                true);
+    }
+}
+
+void BitSpan::reset(size_type first, size_type count) noexcept {
+    if (first < m_size) {
+        fill(m_words.data(), first, first + std::min(count, m_size - first),
+                false);
+    }
+}
+
+auto BitSpan::count() const noexcept -> size_type {
+    const auto full = m_size / WORD_BITS;
+    auto total = popcount(m_words.data(), full);
+
+    if ((m_size % WORD_BITS) != 0) {
+        total += popcount(m_words[full] &
+                ~(ONES << (m_size % WORD_BITS)));
+    }
+
+    return total;
+}
+
+auto BitSpan::any() const noexcept -> bool {
+    return find<false>(m_words.data(), m_size, 0) != npos;
+}
+
+auto BitSpan::find_first_set(size_type pos) const noexcept -> size_type {
+    return find<false>(m_words.data(), m_size, pos);
+}
+
+auto BitSpan::find_first_clear(size_type pos) const noexcept -> size_type {
+    return find<true>(m_words.data(), m_size, pos);
+}
+
+auto BitSpan::operator&=(const BitSpan& other) noexcept -> BitSpan& {
+    combine<And>(m_words.data(), other.m_words.data(),
+            std::min(m_size, other.m_size));
+    return *this;
+}
+
+auto BitSpan::operator|=(const BitSpan& other) noexcept -> BitSpan& {
+    combine<Or>(m_words.data(), other.m_words.data(),
+            std::min(m_size, other.m_size));
+    return *this;
+}
+
+auto BitSpan::operator^=(const BitSpan& other) noexcept -> BitSpan& {
+    combine<Xor>(m_words.data(), other.m_words.data(),
+            std::min(m_size, other.m_size));
+    return *this;
+}
+
+auto BitSpan::andn(const BitSpan& other) noexcept -> BitSpan& {
+    combine<AndNot>(m_words.data(), other.m_words.data(),
+            std::min(m_size, other.m_size));
+    return *this;
+}
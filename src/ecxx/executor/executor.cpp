@@ -0,0 +1,295 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ecxx/executor.hpp"
+
+#include <new>
+#include <limits>
+#include <thread>
+
+using ecxx::Executor;
+
+static constexpr std::size_t DEQUE_CAPACITY{64u};
+static constexpr std::int64_t DEQUE_MASK{DEQUE_CAPACITY - 1u};
+static constexpr std::size_t CHUNKS_MAX{std::numeric_limits<std::uint32_t>::max()};
+
+static constexpr inline
+auto task_encode(std::size_t first, std::size_t last) noexcept -> std::uint64_t {
+    return (std::uint64_t(first) << 32u) | std::uint64_t(last);
+}
+
+static constexpr inline
+auto task_first(std::uint64_t task) noexcept -> std::size_t {
+    return std::size_t(task >> 32u);
+}
+
+static constexpr inline
+auto task_last(std::uint64_t task) noexcept -> std::size_t {
+    return std::size_t(task & 0xFFFFFFFFu);
+}
+
+/*
+ * Chase-Lev deque with fixed capacity, see "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" by Le, Pop, Cohen and Zappa Nardelli.
+ * Only the owner calls push() and pop(), any thread may call steal().
+ */
+struct Executor::Worker {
+    auto push(std::uint64_t task) noexcept -> bool;
+
+    auto pop(std::uint64_t& task) noexcept -> bool;
+
+    auto steal(std::uint64_t& task) noexcept -> bool;
+
+    alignas(CACHE_LINE) std::atomic<std::int64_t> top{0};
+    alignas(CACHE_LINE) std::atomic<std::int64_t> bottom{0};
+    std::atomic<std::uint64_t> tasks[DEQUE_CAPACITY]{};
+    std::thread thread{};
+    std::uint64_t seed{0u};
+};
+
+auto Executor::Worker::push(std::uint64_t task) noexcept -> bool {
+    const auto b = bottom.load(std::memory_order_relaxed);
+    const auto t = top.load(std::memory_order_acquire);
+
+    if ((b - t) >= std::int64_t(DEQUE_CAPACITY)) {
+        return false;
+    }
+
+    tasks[std::size_t(b & DEQUE_MASK)].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+auto Executor::Worker::pop(std::uint64_t& task) noexcept -> bool {
+    const auto b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top.load(std::memory_order_relaxed);
+
+    bool ok = (t <= b);
+
+    if (ok) {
+        task = tasks[std::size_t(b & DEQUE_MASK)].load(
+                std::memory_order_relaxed);
+
+        if (t == b) {
+            ok = top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+    }
+    else {
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return ok;
+}
+
+auto Executor::Worker::steal(std::uint64_t& task) noexcept -> bool {
+    auto t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto b = bottom.load(std::memory_order_acquire);
+
+    bool ok = (t < b);
+
+    if (ok) {
+        task = tasks[std::size_t(t & DEQUE_MASK)].load(
+                std::memory_order_relaxed);
+
+        ok = top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    return ok;
+}
+
+Executor::Executor(Allocator& allocator, std::size_t workers) noexcept :
+    m_allocator{allocator}
+{
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+    }
+
+    if (workers == 0) {
+        workers = 1;
+    }
+
+    /* Over-allocate by one cache line, workers must not share lines */
+    auto memory = m_allocator.allocate(
+            (workers * sizeof(Worker)) + alignof(Worker));
+
+    if (memory != nullptr) {
+        const auto address = (std::uintptr_t(memory) + alignof(Worker)) &
+            ~std::uintptr_t(alignof(Worker) - 1u);
+
+        m_memory = memory;
+        m_workers = reinterpret_cast<Worker*>(address);
+
+        new (&m_workers[0]) Worker{};
+        m_workers[0].seed = 1u;
+
+        for (std::size_t i = 1; i < workers; ++i) {
+            new (&m_workers[i]) Worker{};
+            m_workers[i].seed = i + 1u;
+
+            try {
+                m_workers[i].thread = std::thread{&Executor::wait, this, i};
+            }
+            catch (...) {
+                m_workers[i].~Worker();
+                break;
+            }
+
+            m_workers_count = i + 1u;
+        }
+    }
+}
+
+Executor::~Executor() noexcept {
+    if (m_workers != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+
+        m_condition.notify_all();
+
+        for (std::size_t i = 0; i < m_workers_count; ++i) {
+            if (m_workers[i].thread.joinable()) {
+                m_workers[i].thread.join();
+            }
+
+            m_workers[i].~Worker();
+        }
+
+        m_allocator.deallocate(m_memory);
+    }
+}
+
+void Executor::run(Function function, void* context,
+        std::size_t chunks) noexcept {
+    if (chunks == 0) {
+        return;
+    }
+
+    if ((m_workers == nullptr) || (chunks > CHUNKS_MAX)) {
+        function(context, 0, 0, chunks);
+        return;
+    }
+
+    m_function = function;
+    m_context = context;
+    m_pending.store(chunks, std::memory_order_relaxed);
+
+    /* Workers are idle, the mutex below publishes their deques */
+    for (std::size_t i = 0; i < m_workers_count; ++i) {
+        const auto first = (chunks * i) / m_workers_count;
+        const auto last = (chunks * (i + 1u)) / m_workers_count;
+
+        if (first != last) {
+            m_workers[i].push(task_encode(first, last));
+        }
+    }
+
+    if (m_workers_count > 1) {
+        m_active.store(m_workers_count - 1u, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            ++m_epoch;
+        }
+
+        m_condition.notify_all();
+    }
+
+    work(0);
+
+    while (m_active.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void Executor::work(std::size_t index) noexcept {
+    auto& self = m_workers[index];
+    std::uint64_t task{0u};
+
+    while (m_pending.load(std::memory_order_acquire) != 0) {
+        bool ok = self.pop(task);
+
+        if (!ok && (m_workers_count > 1)) {
+            /* xorshift, picks the first victim */
+            self.seed ^= self.seed << 13u;
+            self.seed ^= self.seed >> 7u;
+            self.seed ^= self.seed << 17u;
+
+            auto victim = std::size_t(self.seed % m_workers_count);
+
+            for (std::size_t i = 0; !ok && (i < m_workers_count); ++i) {
+                if (victim != index) {
+                    ok = m_workers[victim].steal(task);
+                }
+
+                victim = (victim + 1u) % m_workers_count;
+            }
+        }
+
+        if (ok) {
+            auto first = task_first(task);
+            auto last = task_last(task);
+
+            /* Keep the lower half, expose the upper half for thieves */
+            while ((last - first) > 1u) {
+                const auto middle = first + ((last - first) / 2u);
+
+                if (!self.push(task_encode(middle, last))) {
+                    break;
+                }
+
+                last = middle;
+            }
+
+            m_function(m_context, index, first, last);
+            m_pending.fetch_sub(last - first, std::memory_order_acq_rel);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Executor::wait(std::size_t index) noexcept {
+    std::uint64_t epoch{0u};
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+
+            m_condition.wait(lock, [this, epoch] {
+                return m_stop || (m_epoch != epoch);
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            epoch = m_epoch;
+        }
+
+        work(index);
+        m_active.fetch_sub(1u, std::memory_order_release);
+    }
+}
@@ -0,0 +1,157 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/io.hpp"
+
+#include <cerrno>
+
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+using ecxx::Span;
+using ecxx::io::ConstBuffer;
+using ecxx::io::MutableBuffer;
+
+/* Return number of gathered vectors or -EMSGSIZE when they do not fit */
+template<typename T>
+static auto gather(iovec* vectors, const Span<Span<T>>& fragments) noexcept
+        -> std::ptrdiff_t {
+    std::size_t count = 0;
+
+    for (std::size_t i = 0; i < fragments.size(); ++i) {
+        /* Empty fragments would only waste iovec entries */
+        if (!fragments[i].empty()) {
+            if (count == ecxx::io::MAX_FRAGMENTS) {
+                return -EMSGSIZE;
+            }
+
+            vectors[count].iov_base = const_cast<std::uint8_t*>(
+                    fragments[i].data());
+            vectors[count].iov_len = fragments[i].size();
+            ++count;
+        }
+    }
+
+    return std::ptrdiff_t(count);
+}
+
+/* The longest prefix of fragments that fits into single system call */
+static auto batch(const Span<ConstBuffer>& fragments) noexcept
+        -> Span<ConstBuffer> {
+    std::size_t count = 0;
+    std::size_t i = 0;
+
+    for (; i < fragments.size(); ++i) {
+        if (!fragments[i].empty()) {
+            if (count == ecxx::io::MAX_FRAGMENTS) {
+                break;
+            }
+
+            ++count;
+        }
+    }
+
+    return fragments.first(i);
+}
+
+static inline
+auto result(ssize_t value) noexcept -> std::ptrdiff_t {
+    return (value >= 0) ? std::ptrdiff_t(value) : -std::ptrdiff_t(errno);
+}
+
+template<typename T>
+static auto message(int fd, const Span<Span<T>>& fragments, int flags,
+        bool output) noexcept -> std::ptrdiff_t {
+    iovec vectors[ecxx::io::MAX_FRAGMENTS];
+    msghdr header{};
+
+    const auto count = gather(vectors, fragments);
+
+    if (count < 0) {
+        return count;
+    }
+
+    header.msg_iov = vectors;
+    header.msg_iovlen = std::size_t(count);
+
+    return result(output ? ::sendmsg(fd, &header, flags) :
+            ::recvmsg(fd, &header, flags));
+}
+
+template<typename Transfer>
+static auto transfer_all(Span<ConstBuffer>& fragments,
+        Transfer transfer) noexcept -> std::ptrdiff_t {
+    std::ptrdiff_t total = 0;
+
+    while (!(fragments = ecxx::io::consume(fragments, 0)).empty()) {
+        const auto n = transfer(batch(fragments));
+
+        if (n == -EINTR) {
+            continue;
+        }
+
+        /* Error after partial transfer is reported by the next call */
+        if (n <= 0) {
+            return ((n < 0) && (total == 0)) ? n : total;
+        }
+
+        total += n;
+        fragments = ecxx::io::consume(fragments, std::size_t(n));
+    }
+
+    return total;
+}
+
+auto ecxx::io::read(int fd, const Span<MutableBuffer>& fragments) noexcept
+        -> std::ptrdiff_t {
+    iovec vectors[MAX_FRAGMENTS];
+    const auto count = gather(vectors, fragments);
+
+    return (count < 0) ? count : result(::readv(fd, vectors, int(count)));
+}
+
+auto ecxx::io::write(int fd, const Span<ConstBuffer>& fragments) noexcept
+        -> std::ptrdiff_t {
+    iovec vectors[MAX_FRAGMENTS];
+    const auto count = gather(vectors, fragments);
+
+    return (count < 0) ? count : result(::writev(fd, vectors, int(count)));
+}
+
+auto ecxx::io::receive(int fd, const Span<MutableBuffer>& fragments,
+        int flags) noexcept -> std::ptrdiff_t {
+    return message(fd, fragments, flags, false);
+}
+
+auto ecxx::io::send(int fd, const Span<ConstBuffer>& fragments,
+        int flags) noexcept -> std::ptrdiff_t {
+    return message(fd, fragments, flags, true);
+}
+
+auto ecxx::io::write_all(int fd, Span<ConstBuffer>& fragments) noexcept
+        -> std::ptrdiff_t {
+    return transfer_all(fragments, [fd] (const Span<ConstBuffer>& pending) {
+        return write(fd, pending);
+    });
+}
+
+auto ecxx::io::send_all(int fd, Span<ConstBuffer>& fragments,
+        int flags) noexcept -> std::ptrdiff_t {
+    return transfer_all(fragments,
+        [fd, flags] (const Span<ConstBuffer>& pending) {
+            return send(fd, pending, flags);
+        });
+}
@@ -0,0 +1,117 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/io/message.hpp"
+
+#include <new>
+
+using ecxx::io::Message;
+using ecxx::io::ConstBuffer;
+using ecxx::io::MutableBuffer;
+
+static constexpr std::size_t INITIAL_CAPACITY{8u};
+
+Message::Message(Allocator& allocator) noexcept :
+    m_allocator{allocator}
+{ }
+
+Message::~Message() noexcept {
+    clear();
+
+    if (m_fragments != nullptr) {
+        m_allocator.deallocate(m_fragments);
+    }
+}
+
+auto Message::push(ConstBuffer data, void* owned) noexcept -> bool {
+    if (m_count == m_capacity) {
+        const auto capacity = (m_capacity != 0) ?
+            (2u * m_capacity) : INITIAL_CAPACITY;
+
+        /* Fragments and owned pointers share one block */
+        auto memory = m_allocator.allocate(capacity *
+                (sizeof(ConstBuffer) + sizeof(void*)));
+
+        if (memory == nullptr) {
+            return false;
+        }
+
+        auto fragments = static_cast<ConstBuffer*>(memory);
+        auto owned_list = reinterpret_cast<void**>(fragments + capacity);
+
+        for (std::size_t i = 0; i < m_count; ++i) {
+            ::new (&fragments[i]) ConstBuffer{m_fragments[i]};
+            owned_list[i] = m_owned[i];
+        }
+
+        if (m_fragments != nullptr) {
+            m_allocator.deallocate(m_fragments);
+        }
+
+        m_fragments = fragments;
+        m_owned = owned_list;
+        m_capacity = capacity;
+    }
+
+    ::new (&m_fragments[m_count]) ConstBuffer{data};
+    m_owned[m_count] = owned;
+    ++m_count;
+
+    return true;
+}
+
+auto Message::allocate(std::size_t n) noexcept -> MutableBuffer {
+    MutableBuffer buffer;
+
+    if (n != 0) {
+        auto memory = m_allocator.allocate<std::uint8_t>(n);
+
+        if (memory != nullptr) {
+            if (push({memory, n}, memory)) {
+                buffer = {memory, n};
+            }
+            else {
+                m_allocator.deallocate(memory);
+            }
+        }
+    }
+
+    return buffer;
+}
+
+auto Message::append(ConstBuffer data) noexcept -> bool {
+    return data.empty() || push(data, nullptr);
+}
+
+auto Message::size() const noexcept -> std::size_t {
+    std::size_t total = 0;
+
+    for (std::size_t i = 0; i < m_count; ++i) {
+        total += m_fragments[i].size();
+    }
+
+    return total;
+}
+
+void Message::clear() noexcept {
+    for (std::size_t i = 0; i < m_count; ++i) {
+        if (m_owned[i] != nullptr) {
+            m_allocator.deallocate(m_owned[i]);
+        }
+    }
+
+    m_count = 0;
+}
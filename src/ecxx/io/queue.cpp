@@ -0,0 +1,584 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/io/queue.hpp"
+
+#include <new>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ECXX_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#if defined(ECXX_IO_URING)
+/* Kernel limit of submission queue entries */
+static constexpr std::size_t URING_ENTRIES_MAX{32768u};
+
+/* User data of cancel entries, their completions are not reported */
+static constexpr std::uint64_t URING_CANCEL{0u};
+#endif
+
+using ecxx::Span;
+using ecxx::io::Queue;
+using ecxx::io::ConstBuffer;
+using ecxx::io::MutableBuffer;
+
+enum Operation : std::uint8_t {
+    READ,
+    WRITE,
+    RECEIVE,
+    SEND
+};
+
+/*
+ * Fragment list is placed right after request in the same allocation.
+ * Fallback keeps requests in singly linked lists, with io_uring they form
+ * doubly linked list of requests in flight
+ */
+struct Queue::Request {
+    auto vectors() noexcept -> iovec*;
+
+    Request* next{nullptr};
+    Request* prev{nullptr};
+    std::uint64_t data{0u};
+    std::ptrdiff_t result{0};
+    std::int64_t offset{0};
+    int fd{-1};
+    int flags{0};
+    std::uint8_t operation{READ};
+    msghdr message{};
+};
+
+auto Queue::Request::vectors() noexcept -> iovec* {
+    return reinterpret_cast<iovec*>(this + 1);
+}
+
+static inline
+auto result(ssize_t value) noexcept -> std::ptrdiff_t {
+    return (value >= 0) ? std::ptrdiff_t(value) : -std::ptrdiff_t(errno);
+}
+
+static auto execute(int fd, std::uint8_t operation, const msghdr& message,
+        std::int64_t offset, int flags) noexcept -> std::ptrdiff_t {
+    const auto count = int(message.msg_iovlen);
+    ssize_t value;
+
+    switch (operation) {
+    case READ:
+        value = (offset < 0) ? ::readv(fd, message.msg_iov, count) :
+            ::preadv(fd, message.msg_iov, count, off_t(offset));
+        break;
+    case WRITE:
+        value = (offset < 0) ? ::writev(fd, message.msg_iov, count) :
+            ::pwritev(fd, message.msg_iov, count, off_t(offset));
+        break;
+    case RECEIVE:
+        value = ::recvmsg(fd, const_cast<msghdr*>(&message), flags);
+        break;
+    case SEND:
+        value = ::sendmsg(fd, &message, flags);
+        break;
+    default:
+        value = -1;
+        errno = EINVAL;
+        break;
+    }
+
+    return result(value);
+}
+
+#if defined(ECXX_IO_URING)
+/*
+ * Submission and completion rings shared with kernel, mapped with single
+ * mmap. Only this thread writes submission tail and completion head
+ */
+struct Queue::Ring {
+    auto open(unsigned entries) noexcept -> bool;
+
+    void close() noexcept;
+
+    void push(Request& request) noexcept;
+
+    /* Return false when submission queue is full */
+    auto cancel(const Request& request) noexcept -> bool;
+
+    auto enter(unsigned wait) noexcept -> std::ptrdiff_t;
+
+    auto reap(Span<Completion> completions, Queue& queue) noexcept
+        -> std::size_t;
+
+    int fd{-1};
+    unsigned char* memory{nullptr};
+    std::size_t memory_size{0u};
+    io_uring_sqe* sqes{nullptr};
+    std::size_t sqes_size{0u};
+    unsigned* sq_tail{nullptr};
+    unsigned* sq_array{nullptr};
+    unsigned sq_mask{0u};
+    unsigned* cq_head{nullptr};
+    unsigned* cq_tail{nullptr};
+    unsigned cq_mask{0u};
+    io_uring_cqe* cqes{nullptr};
+    unsigned unsubmitted{0u};
+};
+
+auto Queue::Ring::open(unsigned entries) noexcept -> bool {
+    io_uring_params params{};
+
+    fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+
+    if (fd < 0) {
+        return false;
+    }
+
+    constexpr unsigned FEATURES{IORING_FEAT_SINGLE_MMAP |
+        IORING_FEAT_RW_CUR_POS};
+
+    if ((params.features & FEATURES) != FEATURES) {
+        close();
+        return false;
+    }
+
+    memory_size = std::max(
+        params.sq_off.array + (params.sq_entries * sizeof(unsigned)),
+        params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe)));
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    auto rings = ::mmap(nullptr, memory_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, off_t(IORING_OFF_SQ_RING));
+
+    if (rings == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    memory = static_cast<unsigned char*>(rings);
+
+    auto entries_memory = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, off_t(IORING_OFF_SQES));
+
+    if (entries_memory == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    sqes = static_cast<io_uring_sqe*>(entries_memory);
+    sq_tail = reinterpret_cast<unsigned*>(memory + params.sq_off.tail);
+    sq_array = reinterpret_cast<unsigned*>(memory + params.sq_off.array);
+    sq_mask = *reinterpret_cast<unsigned*>(memory + params.sq_off.ring_mask);
+    cq_head = reinterpret_cast<unsigned*>(memory + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(memory + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned*>(memory + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(memory + params.cq_off.cqes);
+
+    return true;
+}
+
+void Queue::Ring::close() noexcept {
+    if (sqes != nullptr) {
+        ::munmap(sqes, sqes_size);
+        sqes = nullptr;
+    }
+
+    if (memory != nullptr) {
+        ::munmap(memory, memory_size);
+        memory = nullptr;
+    }
+
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void Queue::Ring::push(Request& request) noexcept {
+    const auto tail = *sq_tail;
+    const auto index = tail & sq_mask;
+    auto& sqe = sqes[index];
+
+    std::memset(&sqe, 0, sizeof(sqe));
+
+    sqe.fd = request.fd;
+    sqe.user_data = std::uint64_t(std::uintptr_t(&request));
+
+    if ((request.operation == READ) || (request.operation == WRITE)) {
+        sqe.opcode = (request.operation == READ) ?
+            IORING_OP_READV : IORING_OP_WRITEV;
+        sqe.addr = std::uint64_t(std::uintptr_t(request.message.msg_iov));
+        sqe.len = unsigned(request.message.msg_iovlen);
+        sqe.off = std::uint64_t(request.offset);
+    }
+    else {
+        sqe.opcode = (request.operation == RECEIVE) ?
+            IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+        sqe.addr = std::uint64_t(std::uintptr_t(&request.message));
+        sqe.len = 1u;
+        sqe.msg_flags = unsigned(request.flags);
+    }
+
+    sq_array[index] = index;
+
+    /* Entry must be visible to kernel before new tail */
+    __atomic_store_n(sq_tail, tail + 1u, __ATOMIC_RELEASE);
+    ++unsubmitted;
+}
+
+auto Queue::Ring::cancel(const Request& request) noexcept -> bool {
+    /* Kernel consumes entries in enter(), only unsubmitted ones take space */
+    if (unsubmitted > sq_mask) {
+        return false;
+    }
+
+    const auto tail = *sq_tail;
+    const auto index = tail & sq_mask;
+    auto& sqe = sqes[index];
+
+    std::memset(&sqe, 0, sizeof(sqe));
+
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = std::uint64_t(std::uintptr_t(&request));
+    sqe.user_data = URING_CANCEL;
+    sq_array[index] = index;
+
+    __atomic_store_n(sq_tail, tail + 1u, __ATOMIC_RELEASE);
+    ++unsubmitted;
+
+    return true;
+}
+
+auto Queue::Ring::enter(unsigned wait) noexcept -> std::ptrdiff_t {
+    const auto value = ::syscall(__NR_io_uring_enter, fd, unsubmitted, wait,
+            (wait != 0) ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+
+    if (value < 0) {
+        return -std::ptrdiff_t(errno);
+    }
+
+    unsubmitted -= unsigned(value);
+
+    return std::ptrdiff_t(value);
+}
+
+auto Queue::Ring::reap(Span<Completion> completions,
+        Queue& queue) noexcept -> std::size_t {
+    auto head = *cq_head;
+    const auto tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    std::size_t count = 0;
+
+    while ((head != tail) && (count < completions.size())) {
+        const auto& cqe = cqes[head & cq_mask];
+
+        if (cqe.user_data != URING_CANCEL) {
+            auto request = reinterpret_cast<Request*>(
+                    std::uintptr_t(cqe.user_data));
+
+            completions[count++] = {request->data, std::ptrdiff_t(cqe.res)};
+            queue.unlink(request);
+            queue.release(request);
+        }
+
+        ++head;
+    }
+
+    /* Slots are free for kernel only after completions were read */
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    return count;
+}
+#endif
+
+Queue::Queue(Allocator& allocator, std::size_t entries,
+        bool asynchronous) noexcept :
+    m_allocator{allocator},
+    m_capacity{std::max<std::size_t>(entries, 1u)}
+{
+#if defined(ECXX_IO_URING)
+    if (asynchronous && (m_capacity <= URING_ENTRIES_MAX)) {
+        m_ring = m_allocator.construct<Ring>();
+
+        if ((m_ring != nullptr) && !m_ring->open(unsigned(m_capacity))) {
+            m_allocator.destroy(m_ring);
+            m_ring = nullptr;
+        }
+    }
+#else
+    static_cast<void>(asynchronous);
+#endif
+}
+
+Queue::~Queue() noexcept {
+    Completion completions[16];
+
+#if defined(ECXX_IO_URING)
+    /* Receive may wait for peer that never sends, do not depend on it */
+    if (m_ring != nullptr) {
+        cancel();
+    }
+#endif
+
+    /* Kernel may still access requests and buffers, wait for all of them */
+    while (m_pending != 0) {
+        const auto value = complete(completions, 1u);
+
+        /* Interrupted wait or busy rings are retried, other errors are fatal */
+        if ((value < 0) && (value != -EINTR) && (value != -EAGAIN) &&
+                (value != -EBUSY)) {
+            break;
+        }
+    }
+
+#if defined(ECXX_IO_URING)
+    if (m_ring != nullptr) {
+        m_ring->close();
+        m_allocator.destroy(m_ring);
+    }
+#endif
+}
+
+void Queue::release(Request* request) noexcept {
+    m_allocator.destroy(request);
+}
+
+#if defined(ECXX_IO_URING)
+void Queue::unlink(Request* request) noexcept {
+    if (request->prev != nullptr) {
+        request->prev->next = request->next;
+    }
+    else {
+        m_inflight = request->next;
+    }
+
+    if (request->next != nullptr) {
+        request->next->prev = request->prev;
+    }
+}
+
+void Queue::cancel() noexcept {
+    auto request = m_inflight;
+
+    while (request != nullptr) {
+        while ((request != nullptr) && m_ring->cancel(*request)) {
+            request = request->next;
+        }
+
+        std::ptrdiff_t value;
+
+        do {
+            value = m_ring->enter(0u);
+        } while (value == -EINTR);
+
+        /* Remaining operations are left for completion wait */
+        if (value < 0) {
+            break;
+        }
+    }
+}
+#endif
+
+template<typename T>
+auto Queue::prepare(std::uint8_t operation, int fd,
+        const Span<Span<T>>& fragments, std::uint64_t data,
+        std::int64_t offset, int flags) noexcept -> bool {
+    if (m_pending >= m_capacity) {
+        return false;
+    }
+
+    std::size_t count = 0;
+
+    for (std::size_t i = 0; i < fragments.size(); ++i) {
+        count += fragments[i].empty() ? 0u : 1u;
+    }
+
+    if (count > std::size_t(IOV_MAX)) {
+        return false;
+    }
+
+    auto memory = m_allocator.allocate(sizeof(Request) +
+            (count * sizeof(iovec)));
+
+    if (memory == nullptr) {
+        return false;
+    }
+
+    auto request = ::new (memory) Request{};
+    auto vectors = request->vectors();
+
+    for (std::size_t i = 0, n = 0; i < fragments.size(); ++i) {
+        if (!fragments[i].empty()) {
+            vectors[n].iov_base = const_cast<std::uint8_t*>(
+                    fragments[i].data());
+            vectors[n].iov_len = fragments[i].size();
+            ++n;
+        }
+    }
+
+    request->data = data;
+    request->offset = offset;
+    request->fd = fd;
+    request->flags = flags;
+    request->operation = operation;
+    request->message.msg_iov = vectors;
+    request->message.msg_iovlen = count;
+
+#if defined(ECXX_IO_URING)
+    if (m_ring != nullptr) {
+        request->next = m_inflight;
+
+        if (m_inflight != nullptr) {
+            m_inflight->prev = request;
+        }
+
+        m_inflight = request;
+        m_ring->push(*request);
+    }
+    else
+#endif
+    if (m_queued_last != nullptr) {
+        m_queued_last->next = request;
+        m_queued_last = request;
+    }
+    else {
+        m_queued = m_queued_last = request;
+    }
+
+    ++m_pending;
+
+    return true;
+}
+
+auto Queue::read(int fd, const Span<MutableBuffer>& fragments,
+        std::uint64_t data, std::int64_t offset) noexcept -> bool {
+    return prepare(READ, fd, fragments, data, offset, 0);
+}
+
+auto Queue::write(int fd, const Span<ConstBuffer>& fragments,
+        std::uint64_t data, std::int64_t offset) noexcept -> bool {
+    return prepare(WRITE, fd, fragments, data, offset, 0);
+}
+
+auto Queue::receive(int fd, const Span<MutableBuffer>& fragments,
+        std::uint64_t data, int flags) noexcept -> bool {
+    return prepare(RECEIVE, fd, fragments, data, CURRENT, flags);
+}
+
+auto Queue::send(int fd, const Span<ConstBuffer>& fragments,
+        std::uint64_t data, int flags) noexcept -> bool {
+    return prepare(SEND, fd, fragments, data, CURRENT, flags);
+}
+
+auto Queue::submit() noexcept -> std::ptrdiff_t {
+#if defined(ECXX_IO_URING)
+    if (m_ring != nullptr) {
+        return (m_ring->unsubmitted != 0) ? m_ring->enter(0u) : 0;
+    }
+#endif
+
+    std::ptrdiff_t submitted = 0;
+
+    while (m_queued != nullptr) {
+        auto request = m_queued;
+
+        m_queued = request->next;
+        request->next = nullptr;
+        request->result = execute(request->fd, request->operation,
+                request->message, request->offset, request->flags);
+
+        if (m_completed_last != nullptr) {
+            m_completed_last->next = request;
+        }
+        else {
+            m_completed = request;
+        }
+
+        m_completed_last = request;
+        ++submitted;
+    }
+
+    m_queued_last = nullptr;
+
+    return submitted;
+}
+
+auto Queue::complete(Span<Completion> completions,
+        std::size_t min) noexcept -> std::ptrdiff_t {
+    std::size_t count = 0;
+
+#if defined(ECXX_IO_URING)
+    if (m_ring != nullptr) {
+        const auto wait = unsigned(std::min({min, m_pending,
+                    completions.size()}));
+
+        std::ptrdiff_t busy = 0;
+
+        if ((m_ring->unsubmitted != 0) || (wait != 0)) {
+            const auto value = m_ring->enter(wait);
+
+            /* Full completion ring is drained below so retry can proceed */
+            if ((value == -EBUSY) || (value == -EAGAIN)) {
+                busy = value;
+            }
+            else if (value < 0) {
+                return value;
+            }
+        }
+
+        count = m_ring->reap(completions, *this);
+
+        if ((count == 0) && (busy < 0)) {
+            return busy;
+        }
+    }
+    else
+#endif
+    {
+        static_cast<void>(min);
+
+        const auto value = submit();
+
+        if (value < 0) {
+            return value;
+        }
+
+        while ((m_completed != nullptr) && (count < completions.size())) {
+            auto request = m_completed;
+
+            m_completed = request->next;
+            completions[count++] = {request->data, request->result};
+            release(request);
+        }
+
+        if (m_completed == nullptr) {
+            m_completed_last = nullptr;
+        }
+    }
+
+    m_pending -= count;
+
+    return std::ptrdiff_t(count);
+}
@@ -0,0 +1,237 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/trace.hpp"
+
+#include <mutex>
+#include <thread>
+#include <cinttypes>
+
+using ecxx::trace::Event;
+using ecxx::trace::Buffer;
+
+using Clock = std::chrono::steady_clock;
+
+/* Events copied at once before checking that writer did not lap them */
+static constexpr std::size_t BATCH{64u};
+
+static std::mutex g_mutex;
+static Buffer* g_buffers{nullptr};
+static std::uint32_t g_threads{0u};
+
+struct Buffer::Exit {
+    Exit() noexcept = default;
+
+    Exit(Exit&& other) noexcept = delete;
+
+    Exit(const Exit& other) noexcept = delete;
+
+    Exit& operator=(Exit&& other) noexcept = delete;
+
+    Exit& operator=(const Exit& other) noexcept = delete;
+
+    /* Slot of this thread goes away, buffer must not point at it */
+    ~Exit() noexcept {
+        std::lock_guard<std::mutex> lock{g_mutex};
+
+        auto buffer = s_current.exchange(nullptr, std::memory_order_relaxed);
+
+        if (buffer != nullptr) {
+            buffer->m_owner = nullptr;
+        }
+    }
+};
+
+/* Constructed by the first attach() of thread */
+thread_local Buffer::Exit Buffer::s_exit;
+
+/* Ticks of now() per microsecond, measured against steady clock */
+static auto ticks_per_us() noexcept -> double {
+#if defined(__x86_64__) || defined(__i386__)
+    const auto clock_start = Clock::now();
+    const auto ticks_start = ecxx::trace::now();
+
+    while ((Clock::now() - clock_start) < std::chrono::milliseconds{5}) {
+        std::this_thread::yield();
+    }
+
+    const auto ticks = double(ecxx::trace::now() - ticks_start);
+    const auto us = double(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(Clock::now() - clock_start).count()) / 1e3;
+
+    return ticks / us;
+#else
+    return 1e3;
+#endif
+}
+
+static auto write_string(std::FILE* file, const char* string) noexcept
+        -> bool {
+    bool ok = (std::fputc('"', file) != EOF);
+
+    for (; ok && (*string != '\0'); ++string) {
+        if ((*string == '"') || (*string == '\\')) {
+            ok = (std::fputc('\\', file) != EOF);
+        }
+
+        ok = ok && (std::fputc(*string, file) != EOF);
+    }
+
+    return ok && (std::fputc('"', file) != EOF);
+}
+
+Buffer::Buffer(Span<Event> events, const char* name) noexcept :
+    m_name{name}
+{
+    if (!events.empty()) {
+        std::uint64_t capacity = 1u;
+
+        while ((capacity * 2u) <= events.size()) {
+            capacity *= 2u;
+        }
+
+        m_events = events.data();
+        m_mask = capacity - 1u;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{g_mutex};
+
+        m_thread = ++g_threads;
+        m_next = g_buffers;
+        g_buffers = this;
+    }
+
+    attach();
+}
+
+void Buffer::attach() noexcept {
+    if (m_events != nullptr) {
+        static_cast<void>(&s_exit);
+
+        std::lock_guard<std::mutex> lock{g_mutex};
+
+        if (m_owner != nullptr) {
+            m_owner->store(nullptr, std::memory_order_relaxed);
+        }
+
+        auto previous = s_current.exchange(this, std::memory_order_relaxed);
+
+        if (previous != nullptr) {
+            previous->m_owner = nullptr;
+        }
+
+        m_owner = &s_current;
+    }
+}
+
+Buffer::~Buffer() noexcept {
+    std::lock_guard<std::mutex> lock{g_mutex};
+
+    /* Owning thread may be other than the destroying one */
+    if (m_owner != nullptr) {
+        m_owner->store(nullptr, std::memory_order_relaxed);
+    }
+
+    for (auto link = &g_buffers; *link != nullptr; link = &(*link)->m_next) {
+        if (*link == this) {
+            *link = m_next;
+            break;
+        }
+    }
+}
+
+auto ecxx::trace::dump(std::FILE* file) noexcept -> bool {
+    const auto scale = ticks_per_us();
+    const char* separator = "\n";
+    bool ok = (std::fputs("{\"traceEvents\":[", file) != EOF);
+
+    std::lock_guard<std::mutex> lock{g_mutex};
+
+    for (auto buffer = g_buffers; ok && (buffer != nullptr);
+            buffer = buffer->m_next) {
+        if (buffer->m_name != nullptr) {
+            ok = (std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+                        "\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":",
+                        separator, buffer->m_thread) > 0) &&
+                write_string(file, buffer->m_name) &&
+                (std::fputs("}}", file) != EOF);
+            separator = ",\n";
+        }
+
+        const auto capacity = std::uint64_t(buffer->capacity());
+        const auto head = buffer->written();
+        auto index = (head > capacity) ? (head - capacity) : 0u;
+
+        while (ok && (index < head)) {
+            Event events[BATCH];
+            const auto count = std::min<std::uint64_t>(BATCH, head - index);
+
+            for (std::uint64_t i = 0; i < count; ++i) {
+                const auto& event = buffer->m_events[(index + i) &
+                    buffer->m_mask];
+
+                events[i].timestamp = __atomic_load_n(&event.timestamp,
+                        __ATOMIC_RELAXED);
+                events[i].duration = __atomic_load_n(&event.duration,
+                        __ATOMIC_RELAXED);
+                events[i].name = __atomic_load_n(&event.name,
+                        __ATOMIC_RELAXED);
+                events[i].payload = __atomic_load_n(&event.payload,
+                        __ATOMIC_RELAXED);
+            }
+
+            /* Writer may be overwriting the slot of written() - capacity */
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto written = buffer->m_head.load(
+                    std::memory_order_relaxed) + 1u;
+            const auto valid = (written > capacity) ? (written - capacity) : 0u;
+
+            for (std::uint64_t i = 0; ok && (i < count); ++i) {
+                const auto& event = events[i];
+
+                if ((index + i) < valid) {
+                    continue;
+                }
+
+                ok = (std::fputs(separator, file) != EOF) &&
+                    (std::fputs("{\"name\":", file) != EOF) &&
+                    write_string(file, event.name);
+
+                if (ok && (event.duration == Event::INSTANT)) {
+                    ok = std::fprintf(file, ",\"ph\":\"i\",\"s\":\"t\","
+                            "\"ts\":%.3f", double(event.timestamp) / scale) > 0;
+                }
+                else if (ok) {
+                    ok = std::fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,"
+                            "\"dur\":%.3f", double(event.timestamp) / scale,
+                            double(event.duration) / scale) > 0;
+                }
+
+                ok = ok && (std::fprintf(file, ",\"pid\":1,\"tid\":%" PRIu32
+                        ",\"args\":{\"payload\":%" PRIu64 "}}",
+                        buffer->m_thread, event.payload) > 0);
+                separator = ",\n";
+            }
+
+            index += count;
+        }
+    }
+
+    ok = ok && (std::fputs("\n]}\n", file) != EOF);
+
+    return ok && (std::fflush(file) == 0);
+}
@@ -0,0 +1,334 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ecxx/allocator/pool.hpp"
+#include "ecxx/allocator/recorder.hpp"
+#include "ecxx/allocator/standard.hpp"
+#include "ecxx/allocator/small_object.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+using ecxx::Allocator;
+using ecxx::allocator::Pool;
+using ecxx::allocator::Recorder;
+using ecxx::allocator::Standard;
+using ecxx::allocator::SmallObject;
+
+using Event = Recorder::Event;
+using Type = Recorder::Type;
+
+static constexpr std::size_t TYPES{3u};
+static constexpr std::size_t BUCKETS{32u};
+
+struct Statistics {
+    std::uint64_t count[TYPES]{};
+    std::uint64_t latency[TYPES][BUCKETS]{};
+    std::uint64_t skipped{0u};
+    std::uint64_t failed{0u};
+    std::uint64_t time{0u};
+    std::size_t live{0u};
+    std::size_t live_peak{0u};
+    /* Memory owned by allocator, empty for allocators without arena */
+    std::uintptr_t memory{0u};
+    std::uintptr_t memory_end{0u};
+    /* Arena is used in units of granule, runs for small object allocator */
+    std::size_t granule{1u};
+    std::size_t arena_live{0u};
+    std::size_t footprint_peak{0u};
+    std::size_t footprint_live{0u};
+};
+
+struct Block {
+    void* ptr;
+    std::size_t size;
+};
+
+static void usage() {
+    std::fprintf(stderr,
+        "usage: ecxx-replay [-a standard|pool|small] [-s memory-size] trace\n");
+}
+
+static auto read(const char* path, std::vector<Event>& events) -> bool {
+    auto file = std::fopen(path, "rb");
+
+    if (file == nullptr) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    Recorder::FileHeader header{};
+
+    bool ok = (std::fread(&header, sizeof(header), 1, file) == 1) &&
+        (std::memcmp(header.magic, Recorder::MAGIC, sizeof(header.magic)) == 0)
+        && (header.version == Recorder::VERSION) &&
+        (header.event_size == sizeof(Event));
+
+    if (ok) {
+        Event event{};
+
+        while (std::fread(&event, sizeof(event), 1, file) == 1) {
+            events.push_back(event);
+        }
+    }
+    else {
+        std::fprintf(stderr, "%s is not a valid trace\n", path);
+    }
+
+    std::fclose(file);
+
+    return ok;
+}
+
+static auto bucket(std::uint64_t ns) noexcept -> std::size_t {
+    std::size_t index = 0;
+
+    while ((ns > 1u) && (index < (BUCKETS - 1u))) {
+        ns >>= 1u;
+        ++index;
+    }
+
+    return index;
+}
+
+static auto owned(const Statistics& statistics, const void* ptr) noexcept
+        -> bool {
+    return (std::uintptr_t(ptr) >= statistics.memory) &&
+        (std::uintptr_t(ptr) < statistics.memory_end);
+}
+
+/* Block of n bytes at ptr became live */
+static void track(Statistics& statistics, void* ptr, std::size_t n) noexcept {
+    statistics.live_peak = std::max(statistics.live_peak, statistics.live);
+
+    /*
+     * Arena is filled from its start, the end of the highest used granule
+     * is its footprint. Arena live bytes are sampled at the same moment
+     */
+    if (owned(statistics, ptr)) {
+        statistics.arena_live += n;
+
+        const auto address = std::uintptr_t(ptr) + n;
+        const auto end = std::size_t(((address + statistics.granule - 1u) /
+                statistics.granule) * statistics.granule - statistics.memory);
+
+        if (end > statistics.footprint_peak) {
+            statistics.footprint_peak = end;
+            statistics.footprint_live = statistics.arena_live;
+        }
+    }
+}
+
+/* Block of n bytes at ptr was released */
+static void untrack(Statistics& statistics, const void* ptr,
+        std::size_t n) noexcept {
+    statistics.live -= n;
+
+    if (owned(statistics, ptr)) {
+        statistics.arena_live -= n;
+    }
+}
+
+static void replay(Allocator& allocator, const std::vector<Event>& events,
+        Statistics& statistics) {
+    /* Only live blocks are kept, ids of long traces may be sparse */
+    std::unordered_map<std::uint32_t, Block> blocks;
+
+    for (const auto& event : events) {
+        const auto type = std::size_t(event.type);
+        const auto n = std::size_t(event.size);
+        auto it = blocks.find(event.id);
+
+        if ((type >= TYPES) || ((event.type != Type::ALLOCATE) &&
+                    (it == blocks.end()))) {
+            /* Allocation event was dropped from the ring buffer */
+            ++statistics.skipped;
+            continue;
+        }
+
+        void* ptr = nullptr;
+        const auto start = std::chrono::steady_clock::now();
+
+        switch (event.type) {
+        case Type::ALLOCATE:
+            ptr = allocator.allocate(n);
+            break;
+        case Type::REALLOCATE:
+            ptr = allocator.reallocate(it->second.ptr, n);
+            break;
+        case Type::DEALLOCATE:
+            allocator.deallocate(it->second.ptr);
+            break;
+        default:
+            break;
+        }
+
+        const auto stop = std::chrono::steady_clock::now();
+        const auto ns = std::uint64_t(std::chrono::duration_cast<
+            std::chrono::nanoseconds>(stop - start).count());
+
+        statistics.time += ns;
+        ++statistics.count[type];
+        ++statistics.latency[type][bucket(ns)];
+
+        if (event.type == Type::DEALLOCATE) {
+            untrack(statistics, it->second.ptr, it->second.size);
+            blocks.erase(it);
+        }
+        else if (ptr != nullptr) {
+            if (it != blocks.end()) {
+                untrack(statistics, it->second.ptr, it->second.size);
+            }
+
+            statistics.live += n;
+            blocks[event.id] = Block{ptr, n};
+            track(statistics, ptr, n);
+        }
+        else {
+            ++statistics.failed;
+        }
+    }
+
+    for (const auto& block : blocks) {
+        allocator.deallocate(block.second.ptr);
+    }
+}
+
+static void report(const Statistics& statistics) {
+    const auto total = statistics.count[0] + statistics.count[1] +
+        statistics.count[2];
+
+    std::printf("events:        %llu (allocate %llu, reallocate %llu, "
+            "deallocate %llu)\n", static_cast<unsigned long long>(total),
+            static_cast<unsigned long long>(statistics.count[0]),
+            static_cast<unsigned long long>(statistics.count[1]),
+            static_cast<unsigned long long>(statistics.count[2]));
+    std::printf("skipped:       %llu\n",
+            static_cast<unsigned long long>(statistics.skipped));
+    std::printf("failed:        %llu\n",
+            static_cast<unsigned long long>(statistics.failed));
+    std::printf("throughput:    %.0f ops/s\n", (statistics.time != 0) ?
+            (1e9 * double(total) / double(statistics.time)) : 0.0);
+    std::printf("peak live:     %zu bytes\n", statistics.live_peak);
+
+    /* Heap addresses of standard allocator say nothing about footprint */
+    if (statistics.memory != 0) {
+        std::printf("footprint:     %zu bytes\n", statistics.footprint_peak);
+        std::printf("fragmentation: %.2f %%\n",
+                (statistics.footprint_peak != 0) ? (100.0 * (1.0 -
+                (double(statistics.footprint_live) /
+                 double(statistics.footprint_peak)))) : 0.0);
+    }
+    else {
+        std::printf("footprint:     n/a\n");
+        std::printf("fragmentation: n/a\n");
+    }
+    std::printf("\n%-14s %12s %12s %12s\n", "latency [ns]",
+            "allocate", "reallocate", "deallocate");
+
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        const auto& latency = statistics.latency;
+
+        if ((latency[0][i] + latency[1][i] + latency[2][i]) != 0) {
+            std::printf("< %-12llu %12llu %12llu %12llu\n",
+                    2ull << i,
+                    static_cast<unsigned long long>(latency[0][i]),
+                    static_cast<unsigned long long>(latency[1][i]),
+                    static_cast<unsigned long long>(latency[2][i]));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string name{"standard"};
+    std::size_t memory_size{64u << 20u};
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+
+        if ((arg == "-a") && ((i + 1) < argc)) {
+            name = argv[++i];
+        }
+        else if ((arg == "-s") && ((i + 1) < argc)) {
+            memory_size = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if ((path == nullptr) && (arg[0] != '-')) {
+            path = argv[i];
+        }
+        else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (path == nullptr) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Event> events;
+
+    if (!read(path, events)) {
+        return EXIT_FAILURE;
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+        [] (const Event& lhs, const Event& rhs) {
+            return lhs.timestamp < rhs.timestamp;
+        });
+
+    const auto count = (memory_size + sizeof(std::max_align_t) - 1u) /
+        sizeof(std::max_align_t);
+
+    std::unique_ptr<std::max_align_t[]> memory;
+    std::unique_ptr<Allocator> allocator;
+    Standard standard;
+    Statistics statistics{};
+
+    if (name == "standard") {
+        allocator.reset(new Standard{});
+    }
+    else if (name == "pool") {
+        memory.reset(new std::max_align_t[count]);
+        allocator.reset(new Pool{memory.get(), memory_size});
+    }
+    else if (name == "small") {
+        memory.reset(new std::max_align_t[count]);
+        allocator.reset(new SmallObject{memory.get(), memory_size, standard});
+        statistics.granule = SmallObject::RUN_SIZE;
+    }
+    else {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    if (memory) {
+        statistics.memory = std::uintptr_t(memory.get());
+        statistics.memory_end = statistics.memory + memory_size;
+    }
+
+    replay(*allocator, events, statistics);
+    report(statistics);
+
+    return EXIT_SUCCESS;
+}
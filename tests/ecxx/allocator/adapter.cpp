@@ -0,0 +1,107 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/adapter.hpp"
+#include "ecxx/allocator/static_pool.hpp"
+#include "ecxx/allocator/static_slab.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+
+using ecxx::allocator::Adapter;
+using ecxx::allocator::StaticPool;
+using ecxx::allocator::StaticSlab;
+
+namespace {
+
+/* Slab that records use of its native bulk operations */
+class CountingSlab {
+public:
+    auto allocate(std::size_t n) noexcept -> void* {
+        return m_slab.allocate(n);
+    }
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* {
+        return m_slab.reallocate(ptr, n);
+    }
+
+    void deallocate(void* ptr) noexcept {
+        m_slab.deallocate(ptr);
+    }
+
+    auto allocate_bulk(std::size_t n, std::size_t count,
+            ecxx::Span<void*> out) noexcept -> std::size_t {
+        ++m_allocate_bulk_calls;
+        return m_slab.allocate_bulk(n, count, out);
+    }
+
+    void deallocate_bulk(ecxx::Span<void*> ptrs) noexcept {
+        ++m_deallocate_bulk_calls;
+        m_slab.deallocate_bulk(ptrs);
+    }
+
+    StaticSlab<32u, 8u> m_slab{};
+    unsigned m_allocate_bulk_calls{0u};
+    unsigned m_deallocate_bulk_calls{0u};
+};
+
+} /* namespace */
+
+static_assert(ecxx::allocator::HasAllocateBulk<StaticSlab<16u, 4u>>::value,
+        "StaticSlab provides allocate_bulk");
+
+static_assert(ecxx::allocator::HasDeallocateBulk<StaticSlab<16u, 4u>>::value,
+        "StaticSlab provides deallocate_bulk");
+
+static_assert(!ecxx::allocator::HasAllocateBulk<StaticPool<256u>>::value,
+        "StaticPool has no allocate_bulk");
+
+static_assert(!ecxx::allocator::HasDeallocateBulk<StaticPool<256u>>::value,
+        "StaticPool has no deallocate_bulk");
+
+TEST(AdapterTest, ForwardsNativeBulk) {
+    CountingSlab slab{};
+    Adapter<CountingSlab> adapter{slab};
+    ecxx::Allocator& allocator = adapter;
+
+    void* ptrs[10];
+
+    EXPECT_EQ(allocator.allocate_bulk(32u, 10u, ptrs), 8u);
+    EXPECT_EQ(slab.m_allocate_bulk_calls, 1u);
+    EXPECT_EQ(ptrs[8], nullptr);
+    EXPECT_EQ(ptrs[9], nullptr);
+
+    allocator.deallocate_bulk(ptrs);
+    EXPECT_EQ(slab.m_deallocate_bulk_calls, 1u);
+    EXPECT_NE(allocator.allocate(32u), nullptr);
+}
+
+TEST(AdapterTest, FallsBackWithoutNativeBulk) {
+    StaticPool<1024u> pool{};
+    Adapter<StaticPool<1024u>> adapter{pool};
+    ecxx::Allocator& allocator = adapter;
+
+    void* ptrs[4];
+
+    EXPECT_EQ(allocator.allocate_bulk(64u, 3u, ptrs), 3u);
+    EXPECT_NE(ptrs[0], nullptr);
+    EXPECT_NE(ptrs[2], nullptr);
+    EXPECT_EQ(ptrs[3], nullptr);
+
+    allocator.deallocate_bulk(ptrs);
+    EXPECT_NE(allocator.allocate(900u), nullptr);
+}
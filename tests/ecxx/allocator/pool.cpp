@@ -0,0 +1,259 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using ecxx::allocator::Pool;
+
+namespace {
+
+constexpr std::size_t MEMORY_SIZE{4096u};
+
+class PoolTest : public ::testing::Test {
+protected:
+    alignas(std::max_align_t) unsigned char m_memory[MEMORY_SIZE]{};
+    Pool m_pool{m_memory, sizeof(m_memory)};
+};
+
+auto aligned(const void* ptr) noexcept -> bool {
+    return (std::uintptr_t(ptr) % alignof(std::max_align_t)) == 0;
+}
+
+auto inside(const void* ptr, const unsigned char* memory) noexcept -> bool {
+    return (std::uintptr_t(ptr) >= std::uintptr_t(memory)) &&
+        (std::uintptr_t(ptr) < std::uintptr_t(memory + MEMORY_SIZE));
+}
+
+/* Allocates until pool is full, tells if expected block was handed out */
+auto exhaust(Pool& pool, std::size_t n, const void* expected) noexcept -> bool {
+    bool found = false;
+
+    for (auto ptr = pool.allocate(n); ptr != nullptr; ptr = pool.allocate(n)) {
+        found = found || (ptr == expected);
+    }
+
+    return found;
+}
+
+} /* namespace */
+
+TEST_F(PoolTest, AllocateZero) {
+    EXPECT_EQ(m_pool.allocate(0), nullptr);
+}
+
+TEST_F(PoolTest, Alignment) {
+    for (std::size_t n = 1; n < 40; ++n) {
+        auto ptr = m_pool.allocate(n);
+
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(aligned(ptr));
+        EXPECT_TRUE(inside(ptr, m_memory));
+    }
+}
+
+TEST_F(PoolTest, BlocksDoNotOverlap) {
+    auto a = static_cast<unsigned char*>(m_pool.allocate(100));
+    auto b = static_cast<unsigned char*>(m_pool.allocate(100));
+
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_GE(b, a + 100);
+
+    std::memset(a, 0xAA, 100);
+    std::memset(b, 0x55, 100);
+    EXPECT_EQ(a[99], 0xAA);
+}
+
+TEST_F(PoolTest, Exhaustion) {
+    EXPECT_EQ(m_pool.allocate(MEMORY_SIZE), nullptr);
+
+    auto ptr = m_pool.allocate(MEMORY_SIZE / 2);
+
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(m_pool.allocate(MEMORY_SIZE / 2), nullptr);
+
+    m_pool.deallocate(ptr);
+    EXPECT_NE(m_pool.allocate(MEMORY_SIZE / 2), nullptr);
+}
+
+TEST_F(PoolTest, GapReuseAfterFree) {
+    auto a = m_pool.allocate(64);
+    auto b = m_pool.allocate(64);
+    auto c = m_pool.allocate(64);
+
+    ASSERT_NE(c, nullptr);
+
+    /* Fill the tail so the only fitting place is the gap after a */
+    EXPECT_FALSE(exhaust(m_pool, 64, nullptr));
+
+    m_pool.deallocate(b);
+    EXPECT_EQ(m_pool.allocate(64), b);
+    EXPECT_EQ(m_pool.allocate(64), nullptr);
+
+    m_pool.deallocate(a);
+    EXPECT_EQ(m_pool.allocate(32), a);
+}
+
+TEST_F(PoolTest, LastHeaderFollowsFree) {
+    auto a = m_pool.allocate(64);
+    auto b = m_pool.allocate(64);
+
+    ASSERT_NE(b, nullptr);
+
+    /* Freeing the last block moves tail back to a, next block takes b */
+    m_pool.deallocate(b);
+    EXPECT_EQ(m_pool.allocate(64), b);
+
+    m_pool.deallocate(b);
+    m_pool.deallocate(a);
+    EXPECT_EQ(m_pool.allocate(64), a);
+    EXPECT_EQ(m_pool.allocate(64), b);
+}
+
+TEST_F(PoolTest, DeallocateForeignPointer) {
+    int value = 0;
+    auto a = m_pool.allocate(16);
+
+    m_pool.deallocate(&value);
+    m_pool.deallocate(nullptr);
+    EXPECT_NE(m_pool.allocate(16), a);
+}
+
+TEST_F(PoolTest, ReallocateInPlace) {
+    auto a = static_cast<unsigned char*>(m_pool.allocate(32));
+
+    ASSERT_NE(a, nullptr);
+    std::memset(a, 0x11, 32);
+
+    /* The tail gap follows a, so it grows without moving */
+    auto b = static_cast<unsigned char*>(m_pool.reallocate(a, 256));
+
+    EXPECT_EQ(b, a);
+    EXPECT_EQ(b[31], 0x11);
+    EXPECT_EQ(m_pool.reallocate(b, 8), b);
+}
+
+TEST_F(PoolTest, ReallocateMoves) {
+    auto a = static_cast<unsigned char*>(m_pool.allocate(32));
+    auto b = m_pool.allocate(32);
+
+    ASSERT_NE(b, nullptr);
+
+    for (unsigned i = 0; i < 32; ++i) {
+        a[i] = static_cast<unsigned char>(i);
+    }
+
+    auto c = static_cast<unsigned char*>(m_pool.reallocate(a, 512));
+
+    ASSERT_NE(c, nullptr);
+    EXPECT_NE(c, a);
+    EXPECT_TRUE(aligned(c));
+
+    for (unsigned i = 0; i < 32; ++i) {
+        EXPECT_EQ(c[i], i);
+    }
+
+    /* Old place is free again, reached once the tail gap is used up */
+    EXPECT_TRUE(exhaust(m_pool, 32, a));
+}
+
+TEST_F(PoolTest, ReallocateEdges) {
+    auto a = m_pool.reallocate(nullptr, 16);
+
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(m_pool.reallocate(a, 0), nullptr);
+    EXPECT_EQ(m_pool.allocate(16), a);
+    EXPECT_EQ(m_pool.reallocate(a, MEMORY_SIZE), nullptr);
+}
+
+TEST_F(PoolTest, AllocateBulk) {
+    void* ptrs[8];
+
+    EXPECT_EQ(m_pool.allocate_bulk(48, 6, ptrs), 6u);
+
+    for (std::size_t i = 0; i < 6; ++i) {
+        ASSERT_NE(ptrs[i], nullptr);
+        EXPECT_TRUE(aligned(ptrs[i]));
+
+        for (std::size_t j = 0; j < i; ++j) {
+            EXPECT_NE(ptrs[i], ptrs[j]);
+        }
+    }
+
+    EXPECT_EQ(ptrs[6], nullptr);
+    EXPECT_EQ(ptrs[7], nullptr);
+}
+
+TEST_F(PoolTest, AllocateBulkReusesGaps) {
+    void* ptrs[4];
+
+    ASSERT_EQ(m_pool.allocate_bulk(64, 4, ptrs), 4u);
+
+    EXPECT_FALSE(exhaust(m_pool, 64, nullptr));
+
+    m_pool.deallocate(ptrs[0]);
+    m_pool.deallocate(ptrs[2]);
+
+    void* reused[4];
+
+    EXPECT_EQ(m_pool.allocate_bulk(64, 4, reused), 2u);
+    EXPECT_EQ(reused[0], ptrs[0]);
+    EXPECT_EQ(reused[1], ptrs[2]);
+    EXPECT_EQ(reused[2], nullptr);
+}
+
+TEST_F(PoolTest, AllocateBulkCountLimitedByOutput) {
+    void* ptrs[2];
+
+    EXPECT_EQ(m_pool.allocate_bulk(16, 10, ptrs), 2u);
+    EXPECT_EQ(m_pool.allocate_bulk(0, 2, ptrs), 0u);
+    EXPECT_EQ(ptrs[0], nullptr);
+}
+
+TEST_F(PoolTest, DeallocateBulkWithDuplicatesAndNull) {
+    void* ptrs[6];
+
+    ASSERT_EQ(m_pool.allocate_bulk(64, 4, ptrs), 4u);
+
+    void* release[6]{ptrs[3], nullptr, ptrs[0], ptrs[3], ptrs[2], nullptr};
+
+    m_pool.deallocate_bulk(release);
+
+    /* Only second block remains, tail continues right after it */
+    EXPECT_EQ(m_pool.allocate(64), ptrs[2]);
+    EXPECT_EQ(m_pool.allocate(64), ptrs[3]);
+    EXPECT_TRUE(exhaust(m_pool, 64, ptrs[0]));
+}
+
+TEST_F(PoolTest, Move) {
+    auto a = m_pool.allocate(64);
+
+    Pool other{std::move(m_pool)};
+
+    EXPECT_EQ(m_pool.allocate(16), nullptr);
+    EXPECT_NE(other.allocate(64), a);
+
+    m_pool = std::move(other);
+    EXPECT_EQ(other.allocate(16), nullptr);
+    m_pool.deallocate(a);
+    EXPECT_TRUE(exhaust(m_pool, 64, a));
+}
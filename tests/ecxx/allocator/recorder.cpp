@@ -0,0 +1,188 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/recorder.hpp"
+#include "ecxx/allocator/standard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using ecxx::allocator::Recorder;
+
+using Event = Recorder::Event;
+using Type = Recorder::Type;
+
+namespace {
+
+class RecorderTest : public ::testing::Test {
+protected:
+    ecxx::allocator::Standard m_standard{};
+};
+
+} /* namespace */
+
+TEST_F(RecorderTest, RecordsEvents) {
+    Event buffer[8]{};
+    Recorder recorder{m_standard, buffer};
+
+    auto ptr = recorder.allocate(10);
+
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(std::uintptr_t(ptr) % alignof(std::max_align_t), 0u);
+
+    ptr = recorder.reallocate(ptr, 100);
+    ASSERT_NE(ptr, nullptr);
+    recorder.deallocate(ptr);
+
+    Event events[8]{};
+
+    ASSERT_EQ(recorder.events(events), 3u);
+    EXPECT_EQ(events[0].type, Type::ALLOCATE);
+    EXPECT_EQ(events[0].size, 10u);
+    EXPECT_EQ(events[1].type, Type::REALLOCATE);
+    EXPECT_EQ(events[1].size, 100u);
+    EXPECT_EQ(events[2].type, Type::DEALLOCATE);
+    EXPECT_EQ(events[0].id, events[2].id);
+    EXPECT_LE(events[0].timestamp, events[2].timestamp);
+    EXPECT_EQ(recorder.dropped(), 0u);
+}
+
+TEST_F(RecorderTest, RingOverwritesOldest) {
+    Event buffer[4]{};
+    Recorder recorder{m_standard, buffer};
+    void* ptrs[6];
+
+    for (std::size_t i = 0; i < 6; ++i) {
+        ptrs[i] = recorder.allocate(i + 1u);
+    }
+
+    EXPECT_EQ(recorder.dropped(), 2u);
+
+    Event events[8]{};
+
+    ASSERT_EQ(recorder.events(events), 4u);
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(events[i].size, i + 3u);
+    }
+
+    /* Shorter output gets the oldest events */
+    Event oldest[2]{};
+
+    ASSERT_EQ(recorder.events(oldest), 2u);
+    EXPECT_EQ(oldest[0].size, 3u);
+    EXPECT_EQ(oldest[1].size, 4u);
+
+    for (auto ptr : ptrs) {
+        recorder.deallocate(ptr);
+    }
+
+    EXPECT_EQ(recorder.dropped(), 8u);
+}
+
+TEST_F(RecorderTest, WithoutBufferEverythingIsDropped) {
+    Recorder recorder{m_standard, {}};
+
+    recorder.deallocate(recorder.allocate(8));
+
+    Event events[2]{};
+
+    EXPECT_EQ(recorder.events(events), 0u);
+    EXPECT_EQ(recorder.dropped(), 2u);
+}
+
+TEST_F(RecorderTest, EventsWhileRecording) {
+    Event buffer[64]{};
+    Recorder recorder{m_standard, buffer};
+    std::atomic<bool> stop{false};
+
+    std::thread thread{[&recorder, &stop] () noexcept {
+        while (!stop.load()) {
+            recorder.deallocate(recorder.allocate(16));
+        }
+    }};
+
+    Event events[64]{};
+
+    for (unsigned i = 0; i < 1000; ++i) {
+        const auto count = recorder.events(events);
+
+        /* Copies are consistent, every event is whole */
+        for (std::size_t j = 0; j < count; ++j) {
+            ASSERT_EQ(events[j].size,
+                (events[j].type == Type::ALLOCATE) ? 16u : 0u);
+        }
+    }
+
+    stop = true;
+    thread.join();
+}
+
+TEST_F(RecorderTest, FileRoundTrip) {
+    auto file = std::tmpfile();
+
+    ASSERT_NE(file, nullptr);
+
+    {
+        /* Small buffer forces writes before flush */
+        Event buffer[2]{};
+        Recorder recorder{m_standard, buffer, file};
+
+        auto a = recorder.allocate(24);
+        auto b = recorder.allocate(48);
+
+        b = recorder.reallocate(b, 96);
+        recorder.deallocate(a);
+        recorder.deallocate(b);
+
+        EXPECT_EQ(recorder.dropped(), 0u);
+    }
+
+    std::rewind(file);
+
+    Recorder::FileHeader header{};
+
+    ASSERT_EQ(std::fread(&header, sizeof(header), 1, file), 1u);
+    EXPECT_EQ(std::memcmp(header.magic, Recorder::MAGIC, sizeof(header.magic)),
+            0);
+    EXPECT_EQ(header.version, Recorder::VERSION);
+    EXPECT_EQ(header.event_size, sizeof(Event));
+
+    std::vector<Event> events;
+    Event event{};
+
+    while (std::fread(&event, sizeof(event), 1, file) == 1) {
+        events.push_back(event);
+    }
+
+    std::fclose(file);
+
+    ASSERT_EQ(events.size(), 5u);
+    EXPECT_EQ(events[0].type, Type::ALLOCATE);
+    EXPECT_EQ(events[0].size, 24u);
+    EXPECT_EQ(events[1].size, 48u);
+    EXPECT_EQ(events[2].type, Type::REALLOCATE);
+    EXPECT_EQ(events[2].id, events[1].id);
+    EXPECT_EQ(events[2].size, 96u);
+    EXPECT_EQ(events[3].type, Type::DEALLOCATE);
+    EXPECT_EQ(events[3].id, events[0].id);
+    EXPECT_EQ(events[4].id, events[1].id);
+}
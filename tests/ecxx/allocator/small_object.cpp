@@ -0,0 +1,209 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/small_object.hpp"
+#include "ecxx/allocator/standard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using ecxx::allocator::SmallObject;
+
+namespace {
+
+constexpr std::size_t RUNS{4u};
+
+constexpr std::size_t MEMORY_SIZE{RUNS * SmallObject::RUN_SIZE};
+
+/* Forwards to standard allocator and counts live upstream blocks */
+class Upstream final : public ecxx::Allocator {
+public:
+    auto allocate(std::size_t n) noexcept -> void* override {
+        auto ptr = m_standard.allocate(n);
+        if (ptr != nullptr) { ++m_live; }
+        return ptr;
+    }
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* override {
+        if (ptr == nullptr) { return allocate(n); }
+        if (n == 0) { deallocate(ptr); return nullptr; }
+        return m_standard.reallocate(ptr, n);
+    }
+
+    void deallocate(void* ptr) noexcept override {
+        if (ptr != nullptr) { --m_live; }
+        m_standard.deallocate(ptr);
+    }
+
+    auto live() const noexcept -> std::size_t { return m_live; }
+private:
+    ecxx::allocator::Standard m_standard{};
+    std::size_t m_live{0u};
+};
+
+class SmallObjectTest : public ::testing::Test {
+protected:
+    alignas(SmallObject::RUN_SIZE) unsigned char m_memory[MEMORY_SIZE]{};
+    Upstream m_upstream{};
+    SmallObject m_small{m_memory, sizeof(m_memory), m_upstream};
+
+    auto owned(const void* ptr) const noexcept -> bool {
+        return (std::uintptr_t(ptr) >= std::uintptr_t(m_memory)) &&
+            (std::uintptr_t(ptr) < std::uintptr_t(m_memory + MEMORY_SIZE));
+    }
+};
+
+} /* namespace */
+
+TEST_F(SmallObjectTest, AllocateZero) {
+    EXPECT_EQ(m_small.allocate(0), nullptr);
+}
+
+TEST_F(SmallObjectTest, SmallRequestsStayLocal) {
+    /* Sizes span three classes, each class keeps one run of its own */
+    for (std::size_t n = 1; n <= 32; ++n) {
+        auto ptr = m_small.allocate(n);
+
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(owned(ptr));
+        EXPECT_EQ(std::uintptr_t(ptr) % 8u, 0u);
+
+        std::memset(ptr, 0xA5, n);
+        m_small.deallocate(ptr);
+    }
+
+    EXPECT_EQ(m_upstream.live(), 0u);
+}
+
+TEST_F(SmallObjectTest, LargeRequestsGoUpstream) {
+    auto ptr = m_small.allocate(SmallObject::MAX_SIZE + 1u);
+
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_FALSE(owned(ptr));
+    EXPECT_EQ(m_upstream.live(), 1u);
+
+    m_small.deallocate(ptr);
+    EXPECT_EQ(m_upstream.live(), 0u);
+}
+
+TEST_F(SmallObjectTest, SameClassBlocksAreReused) {
+    auto a = m_small.allocate(24);
+    auto b = m_small.allocate(30);
+
+    ASSERT_NE(b, nullptr);
+    EXPECT_NE(a, b);
+
+    m_small.deallocate(a);
+    EXPECT_EQ(m_small.allocate(32), a);
+}
+
+TEST_F(SmallObjectTest, FallsBackUpstreamWhenMemoryIsUsedUp) {
+    /* Each class takes its own run, RUNS + 1 classes need one run too many */
+    void* ptrs[RUNS + 1u];
+
+    for (std::size_t i = 0; i < RUNS; ++i) {
+        ptrs[i] = m_small.allocate(8u << i);
+        ASSERT_TRUE(owned(ptrs[i]));
+    }
+
+    ptrs[RUNS] = m_small.allocate(SmallObject::MAX_SIZE);
+    EXPECT_FALSE(owned(ptrs[RUNS]));
+    EXPECT_EQ(m_upstream.live(), 1u);
+
+    m_small.deallocate_bulk(ptrs);
+    EXPECT_EQ(m_upstream.live(), 0u);
+}
+
+TEST_F(SmallObjectTest, EmptyRunsAreRecycled) {
+    constexpr std::size_t BLOCK{1024u};
+    constexpr std::size_t BLOCKS{(RUNS * SmallObject::RUN_SIZE) / BLOCK};
+
+    void* ptrs[BLOCKS];
+
+    /* Run headers take space, so the last blocks come from upstream */
+    EXPECT_EQ(m_small.allocate_bulk(BLOCK, BLOCKS, ptrs), BLOCKS);
+    EXPECT_GT(m_upstream.live(), 0u);
+
+    m_small.deallocate_bulk(ptrs);
+    EXPECT_EQ(m_upstream.live(), 0u);
+
+    /* Freed runs serve another class */
+    auto ptr = m_small.allocate(8);
+
+    EXPECT_TRUE(owned(ptr));
+    m_small.deallocate(ptr);
+}
+
+TEST_F(SmallObjectTest, ReallocateWithinClass) {
+    auto ptr = static_cast<unsigned char*>(m_small.allocate(17));
+
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(m_small.reallocate(ptr, 32), ptr);
+    EXPECT_EQ(m_small.reallocate(ptr, 1), ptr);
+    m_small.deallocate(ptr);
+}
+
+TEST_F(SmallObjectTest, ReallocateMovesAcrossClassesAndUpstream) {
+    auto ptr = static_cast<unsigned char*>(m_small.allocate(16));
+
+    ASSERT_NE(ptr, nullptr);
+
+    for (unsigned i = 0; i < 16; ++i) {
+        ptr[i] = static_cast<unsigned char>(i);
+    }
+
+    auto moved = static_cast<unsigned char*>(m_small.reallocate(ptr, 100));
+
+    ASSERT_NE(moved, nullptr);
+    EXPECT_NE(moved, ptr);
+    EXPECT_TRUE(owned(moved));
+
+    auto large = static_cast<unsigned char*>(m_small.reallocate(moved, 4096));
+
+    ASSERT_NE(large, nullptr);
+    EXPECT_FALSE(owned(large));
+
+    for (unsigned i = 0; i < 16; ++i) {
+        EXPECT_EQ(large[i], i);
+    }
+
+    EXPECT_EQ(m_small.reallocate(large, 0), nullptr);
+    EXPECT_EQ(m_upstream.live(), 0u);
+}
+
+TEST_F(SmallObjectTest, BulkWithNullEntries) {
+    void* ptrs[8];
+
+    EXPECT_EQ(m_small.allocate_bulk(64, 6, ptrs), 6u);
+    EXPECT_EQ(ptrs[6], nullptr);
+    EXPECT_EQ(ptrs[7], nullptr);
+
+    for (std::size_t i = 0; i < 6; ++i) {
+        EXPECT_TRUE(owned(ptrs[i]));
+
+        for (std::size_t j = 0; j < i; ++j) {
+            EXPECT_NE(ptrs[i], ptrs[j]);
+        }
+    }
+
+    m_small.deallocate_bulk(ptrs);
+
+    EXPECT_EQ(m_small.allocate_bulk(0, 2, ptrs), 0u);
+    EXPECT_EQ(ptrs[0], nullptr);
+}
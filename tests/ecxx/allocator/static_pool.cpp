@@ -0,0 +1,200 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/static_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using ecxx::allocator::StaticPool;
+
+namespace {
+
+using Pool = StaticPool<256u, 16u>;
+
+/* Pool must be usable straight from zeroed storage */
+Pool g_pool;
+
+auto pattern(void* ptr, std::size_t n, unsigned char seed) noexcept -> void* {
+    auto bytes = static_cast<unsigned char*>(ptr);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        bytes[i] = static_cast<unsigned char>(seed + i);
+    }
+
+    return ptr;
+}
+
+auto has_pattern(const void* ptr, std::size_t n,
+        unsigned char seed) noexcept -> bool {
+    auto bytes = static_cast<const unsigned char*>(ptr);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (bytes[i] != static_cast<unsigned char>(seed + i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} /* namespace */
+
+TEST(StaticPoolTest, GlobalPool) {
+    auto ptr = g_pool.allocate(32u);
+
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(g_pool.owns(ptr));
+    g_pool.deallocate(ptr);
+}
+
+TEST(StaticPoolTest, AlignedBlocks) {
+    Pool pool;
+
+    for (std::size_t n : {1u, 3u, 17u, 5u}) {
+        auto ptr = pool.allocate(n);
+
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(pool.owns(ptr));
+        EXPECT_EQ(std::uintptr_t(ptr) % Pool::ALIGN, 0u);
+    }
+}
+
+TEST(StaticPoolTest, Exhaustion) {
+    Pool pool;
+    std::vector<void*> ptrs;
+
+    EXPECT_EQ(pool.allocate(0u), nullptr);
+    EXPECT_EQ(pool.allocate(Pool::SIZE), nullptr);
+
+    for (void* ptr = pool.allocate(32u); ptr != nullptr;
+            ptr = pool.allocate(32u)) {
+        ptrs.push_back(pattern(ptr, 32u, std::uint8_t(ptrs.size())));
+    }
+
+    ASSERT_FALSE(ptrs.empty());
+    EXPECT_LE(ptrs.size(), Pool::SIZE / 32u);
+
+    /* Blocks never overlap */
+    for (std::size_t i = 0; i < ptrs.size(); ++i) {
+        EXPECT_TRUE(has_pattern(ptrs[i], 32u, std::uint8_t(i)));
+    }
+
+    pool.deallocate(ptrs.back());
+    EXPECT_EQ(pool.allocate(32u), ptrs.back());
+}
+
+TEST(StaticPoolTest, FreedNeighboursCoalesce) {
+    Pool pool;
+    auto a = pool.allocate(48u);
+    auto b = pool.allocate(48u);
+    auto c = pool.allocate(48u);
+
+    ASSERT_NE(c, nullptr);
+
+    /* Two blocks worth of space is only available once both are freed */
+    const auto span = std::size_t(static_cast<unsigned char*>(c) -
+            static_cast<unsigned char*>(a)) - Pool::ALIGN;
+
+    EXPECT_EQ(pool.allocate(span), nullptr);
+
+    pool.deallocate(a);
+    EXPECT_EQ(pool.allocate(span), nullptr);
+
+    pool.deallocate(b);
+    EXPECT_EQ(pool.allocate(span), a);
+}
+
+TEST(StaticPoolTest, ReallocateShrinksAndGrowsInPlace) {
+    Pool pool;
+    auto a = pattern(pool.allocate(64u), 64u, 1u);
+
+    EXPECT_EQ(pool.reallocate(a, 16u), a);
+    EXPECT_TRUE(has_pattern(a, 16u, 1u));
+
+    /* Space behind the last block is free */
+    EXPECT_EQ(pool.reallocate(a, 100u), a);
+    EXPECT_TRUE(has_pattern(a, 16u, 1u));
+}
+
+TEST(StaticPoolTest, ReallocateMovesWhenNeighbourIsUsed) {
+    Pool pool;
+    auto a = pattern(pool.allocate(32u), 32u, 7u);
+    auto b = pool.allocate(32u);
+
+    ASSERT_NE(b, nullptr);
+
+    auto moved = pool.reallocate(a, 64u);
+
+    ASSERT_NE(moved, nullptr);
+    EXPECT_NE(moved, a);
+    EXPECT_TRUE(has_pattern(moved, 32u, 7u));
+
+    /* Old block was released */
+    EXPECT_EQ(pool.allocate(32u), a);
+}
+
+TEST(StaticPoolTest, FailedReallocateKeepsBlock) {
+    Pool pool;
+    auto a = pattern(pool.allocate(32u), 32u, 3u);
+    auto b = pool.allocate(32u);
+
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(pool.reallocate(a, Pool::SIZE), nullptr);
+    EXPECT_TRUE(has_pattern(a, 32u, 3u));
+
+    pool.deallocate(a);
+    EXPECT_EQ(pool.allocate(32u), a);
+}
+
+TEST(StaticPoolTest, ReallocateNullAndZero) {
+    Pool pool;
+    auto a = pool.reallocate(nullptr, 32u);
+
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(pool.reallocate(a, 0u), nullptr);
+    EXPECT_EQ(pool.allocate(32u), a);
+}
+
+TEST(StaticPoolTest, ForeignPointers) {
+    Pool pool;
+    Pool other;
+    unsigned char local[64]{};
+    auto a = pool.allocate(32u);
+    auto foreign = other.allocate(32u);
+
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(foreign, nullptr);
+
+    EXPECT_FALSE(pool.owns(local));
+    EXPECT_FALSE(pool.owns(foreign));
+    EXPECT_EQ(pool.reallocate(local, 16u), nullptr);
+    EXPECT_EQ(pool.reallocate(foreign, 16u), nullptr);
+    EXPECT_EQ(pool.reallocate(foreign, 128u), nullptr);
+
+    pool.deallocate(local);
+    pool.deallocate(foreign);
+
+    /* Neither pool was touched */
+    EXPECT_TRUE(other.owns(foreign));
+    EXPECT_EQ(other.reallocate(foreign, 16u), foreign);
+    EXPECT_EQ(pool.reallocate(a, 16u), a);
+    EXPECT_NE(pool.allocate(32u), a);
+}
@@ -0,0 +1,116 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/allocator/static_slab.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+
+using ecxx::Span;
+using ecxx::allocator::StaticSlab;
+
+namespace {
+
+/* Count spans two bitmap words, last one partially */
+using Slab = StaticSlab<32u, 70u>;
+
+} /* namespace */
+
+TEST(StaticSlabTest, SizeLimits) {
+    Slab slab;
+
+    EXPECT_EQ(slab.allocate(0u), nullptr);
+    EXPECT_EQ(slab.allocate(Slab::BLOCK_SIZE + 1u), nullptr);
+    EXPECT_NE(slab.allocate(Slab::BLOCK_SIZE), nullptr);
+}
+
+TEST(StaticSlabTest, Exhaustion) {
+    Slab slab;
+    std::set<void*> ptrs;
+
+    for (std::size_t i = 0; i < Slab::COUNT; ++i) {
+        auto ptr = slab.allocate(8u);
+
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_TRUE(slab.owns(ptr));
+        EXPECT_EQ(std::uintptr_t(ptr) % Slab::BLOCK_ALIGN, 0u);
+        ptrs.insert(ptr);
+    }
+
+    EXPECT_EQ(ptrs.size(), Slab::COUNT);
+    EXPECT_EQ(slab.allocate(8u), nullptr);
+
+    auto freed = *ptrs.rbegin();
+
+    slab.deallocate(freed);
+    EXPECT_EQ(slab.allocate(8u), freed);
+    EXPECT_EQ(slab.allocate(8u), nullptr);
+}
+
+TEST(StaticSlabTest, Reallocate) {
+    Slab slab;
+    auto a = slab.reallocate(nullptr, 8u);
+
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(slab.reallocate(a, Slab::BLOCK_SIZE), a);
+    EXPECT_EQ(slab.reallocate(a, 1u), a);
+
+    /* Block cannot grow, it stays allocated */
+    EXPECT_EQ(slab.reallocate(a, Slab::BLOCK_SIZE + 1u), nullptr);
+    EXPECT_NE(slab.allocate(8u), a);
+
+    EXPECT_EQ(slab.reallocate(a, 0u), nullptr);
+    EXPECT_EQ(slab.allocate(8u), a);
+}
+
+TEST(StaticSlabTest, ForeignPointers) {
+    Slab slab;
+    Slab other;
+    unsigned char local[Slab::BLOCK_SIZE]{};
+    auto foreign = other.allocate(8u);
+
+    ASSERT_NE(foreign, nullptr);
+
+    EXPECT_FALSE(slab.owns(local));
+    EXPECT_FALSE(slab.owns(foreign));
+    EXPECT_EQ(slab.reallocate(local, 8u), nullptr);
+    EXPECT_EQ(slab.reallocate(foreign, 8u), nullptr);
+
+    slab.deallocate(local);
+    slab.deallocate(foreign);
+
+    EXPECT_NE(other.allocate(8u), foreign);
+}
+
+TEST(StaticSlabTest, BulkStopsWhenFull) {
+    Slab slab;
+    void* ptrs[80];
+    Span<void*> out{ptrs, 80u};
+
+    EXPECT_EQ(slab.allocate_bulk(8u, 80u, out), Slab::COUNT);
+
+    for (std::size_t i = Slab::COUNT; i < 80u; ++i) {
+        EXPECT_EQ(ptrs[i], nullptr);
+    }
+
+    slab.deallocate_bulk(Span<void*>{ptrs, 10u});
+    EXPECT_EQ(slab.allocate_bulk(8u, 80u, out), 10u);
+    EXPECT_EQ(slab.allocate_bulk(Slab::BLOCK_SIZE + 1u, 1u, out), 0u);
+    EXPECT_EQ(ptrs[0], nullptr);
+}
@@ -0,0 +1,92 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/bit_span.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using ecxx::BitSpan;
+
+namespace {
+
+constexpr std::uint64_t ONES{~std::uint64_t(0)};
+
+} /* namespace */
+
+TEST(BitSpanTest, SetResetAcrossWords) {
+    std::uint64_t words[3]{};
+    BitSpan bits{{words, 3u}, 150u};
+
+    bits.set(60u, 10u);
+
+    EXPECT_EQ(bits.count(), 10u);
+    EXPECT_EQ(bits.find_first_set(), 60u);
+    EXPECT_EQ(bits.find_first_clear(60u), 70u);
+
+    bits.reset(62u, 4u);
+
+    EXPECT_EQ(bits.count(), 6u);
+    EXPECT_FALSE(bits.test(63u));
+    EXPECT_TRUE(bits.test(66u));
+    EXPECT_EQ(bits.find_first_set(70u), BitSpan::npos);
+}
+
+TEST(BitSpanTest, AndKeepsBitsAboveShorterOperand) {
+    std::uint64_t dst_words[2]{ONES, ONES};
+    std::uint64_t src_words[2]{0u, 0u};
+    BitSpan dst{{dst_words, 2u}, 128u};
+
+    dst &= BitSpan{{src_words, 2u}, 70u};
+
+    EXPECT_EQ(dst.count(), 58u);
+    EXPECT_EQ(dst.find_first_set(), 70u);
+}
+
+TEST(BitSpanTest, OrXorKeepBitsAboveShorterOperand) {
+    std::uint64_t dst_words[5]{};
+    std::uint64_t src_words[5]{ONES, ONES, ONES, ONES, ONES};
+    BitSpan dst{{dst_words, 5u}, 320u};
+    const BitSpan src{{src_words, 5u}, 300u};
+
+    dst |= src;
+
+    EXPECT_EQ(dst.count(), 300u);
+    EXPECT_EQ(dst.find_first_clear(), 300u);
+
+    dst.set(310u);
+    dst ^= src;
+
+    EXPECT_EQ(dst.count(), 1u);
+    EXPECT_EQ(dst.find_first_set(), 310u);
+}
+
+TEST(BitSpanTest, AndnKeepsBitsAboveShorterOperand) {
+    std::uint64_t dst_words[5]{ONES, ONES, ONES, ONES, ONES};
+    std::uint64_t src_words[5]{ONES, ONES, ONES, ONES, ONES};
+    BitSpan dst{{dst_words, 5u}, 320u};
+
+    dst.andn(BitSpan{{src_words, 5u}, 5u});
+
+    EXPECT_EQ(dst.count(), 315u);
+    EXPECT_EQ(dst.find_first_set(), 5u);
+
+    dst.andn(BitSpan{{src_words, 5u}, 257u});
+
+    EXPECT_EQ(dst.count(), 63u);
+    EXPECT_EQ(dst.find_first_set(), 257u);
+}
@@ -0,0 +1,68 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ECXX_TESTS_COUNTING_ALLOCATOR_HPP
+#define ECXX_TESTS_COUNTING_ALLOCATOR_HPP
+
+#include "ecxx/allocator/standard.hpp"
+
+#include <cstddef>
+
+namespace ecxx {
+namespace tests {
+
+/* Forwards to standard allocator, counts live blocks and fails on request */
+class CountingAllocator final : public Allocator {
+public:
+    auto allocate(std::size_t n) noexcept -> void* override {
+        void* ptr = nullptr;
+
+        if (!fail) {
+            ptr = m_standard.allocate(n);
+            live += (ptr != nullptr) ? 1u : 0u;
+        }
+
+        return ptr;
+    }
+
+    auto reallocate(void* ptr, std::size_t n) noexcept -> void* override {
+        if (ptr == nullptr) {
+            return allocate(n);
+        }
+
+        if (n == 0) {
+            deallocate(ptr);
+            return nullptr;
+        }
+
+        return fail ? nullptr : m_standard.reallocate(ptr, n);
+    }
+
+    void deallocate(void* ptr) noexcept override {
+        live -= (ptr != nullptr) ? 1u : 0u;
+        m_standard.deallocate(ptr);
+    }
+
+    std::size_t live{0u};
+    bool fail{false};
+private:
+    allocator::Standard m_standard{};
+};
+
+} /* namespace tests */
+} /* namespace ecxx */
+
+#endif /* ECXX_TESTS_COUNTING_ALLOCATOR_HPP */
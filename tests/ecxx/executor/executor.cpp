@@ -0,0 +1,153 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/executor.hpp"
+#include "ecxx/parallel.hpp"
+#include "ecxx/allocator/standard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using ecxx::Executor;
+
+namespace {
+
+constexpr std::size_t WORKERS{4u};
+
+struct Visits {
+    std::vector<std::atomic<unsigned>> chunks;
+    std::atomic<bool> bad_worker{false};
+    std::atomic<bool> bad_range{false};
+};
+
+void visit(void* context, std::size_t worker, std::size_t begin,
+        std::size_t end) noexcept {
+    auto visits = static_cast<Visits*>(context);
+
+    if (worker >= WORKERS) {
+        visits->bad_worker = true;
+    }
+
+    if ((begin >= end) || (end > visits->chunks.size())) {
+        visits->bad_range = true;
+        return;
+    }
+
+    for (auto i = begin; i < end; ++i) {
+        visits->chunks[i].fetch_add(1u, std::memory_order_relaxed);
+    }
+}
+
+class ExecutorTest : public ::testing::Test {
+protected:
+    ecxx::allocator::Standard m_allocator{};
+    Executor m_executor{m_allocator, WORKERS};
+};
+
+} /* namespace */
+
+TEST_F(ExecutorTest, Workers) {
+    EXPECT_EQ(m_executor.workers(), WORKERS);
+    EXPECT_EQ(&m_executor.allocator(), &m_allocator);
+}
+
+TEST_F(ExecutorTest, ZeroChunks) {
+    Visits visits{std::vector<std::atomic<unsigned>>(1u), {}, {}};
+
+    m_executor.run(visit, &visits, 0);
+    EXPECT_EQ(visits.chunks[0].load(), 0u);
+}
+
+TEST_F(ExecutorTest, EveryChunkRunsOnce) {
+    for (std::size_t chunks : {1u, 2u, 3u, 7u, 64u, 1000u, 4099u}) {
+        Visits visits{std::vector<std::atomic<unsigned>>(chunks), {}, {}};
+
+        m_executor.run(visit, &visits, chunks);
+
+        EXPECT_FALSE(visits.bad_worker.load());
+        EXPECT_FALSE(visits.bad_range.load());
+
+        for (std::size_t i = 0; i < chunks; ++i) {
+            ASSERT_EQ(visits.chunks[i].load(), 1u) << "chunk " << i;
+        }
+    }
+}
+
+TEST_F(ExecutorTest, RepeatedRuns) {
+    constexpr std::size_t CHUNKS{257u};
+
+    Visits visits{std::vector<std::atomic<unsigned>>(CHUNKS), {}, {}};
+
+    for (unsigned run = 0; run < 100; ++run) {
+        m_executor.run(visit, &visits, CHUNKS);
+    }
+
+    for (std::size_t i = 0; i < CHUNKS; ++i) {
+        ASSERT_EQ(visits.chunks[i].load(), 100u) << "chunk " << i;
+    }
+}
+
+TEST_F(ExecutorTest, SingleWorker) {
+    Executor executor{m_allocator, 1u};
+    Visits visits{std::vector<std::atomic<unsigned>>(100u), {}, {}};
+
+    executor.run(visit, &visits, 100u);
+
+    for (std::size_t i = 0; i < 100u; ++i) {
+        ASSERT_EQ(visits.chunks[i].load(), 1u);
+    }
+}
+
+TEST_F(ExecutorTest, ParallelFor) {
+    std::vector<std::uint32_t> values(10007u, 1u);
+
+    ecxx::parallel_for(m_executor, ecxx::Span<std::uint32_t>{values}, 100u,
+        [] (ecxx::Span<std::uint32_t> span) noexcept {
+            for (auto& value : span) {
+                ++value;
+            }
+        });
+
+    for (auto value : values) {
+        ASSERT_EQ(value, 2u);
+    }
+}
+
+TEST_F(ExecutorTest, ParallelReduce) {
+    std::vector<std::uint64_t> values(10007u);
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = i;
+    }
+
+    auto sum = ecxx::parallel_reduce(m_executor,
+        ecxx::Span<const std::uint64_t>{values}, 64u, std::uint64_t(0),
+        [] (std::uint64_t acc, ecxx::Span<const std::uint64_t> span) noexcept {
+            for (auto value : span) {
+                acc += value;
+            }
+            return acc;
+        },
+        [] (std::uint64_t lhs, std::uint64_t rhs) noexcept {
+            return lhs + rhs;
+        });
+
+    EXPECT_EQ(sum, (values.size() * (values.size() - 1u)) / 2u);
+}
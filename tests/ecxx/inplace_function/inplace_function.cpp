@@ -0,0 +1,185 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/inplace_function.hpp"
+#include "counting_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+using ecxx::InplaceFunction;
+using ecxx::InplaceMoveFunction;
+using ecxx::tests::CountingAllocator;
+
+namespace {
+
+/* Callable larger than default capacity */
+struct Large {
+    auto operator()(int value) const noexcept -> int {
+        return value + int(data[0] + data[7]);
+    }
+
+    std::array<std::uint64_t, 8> data;
+};
+
+} /* namespace */
+
+TEST(InplaceFunctionTest, Empty) {
+    InplaceFunction<int(int)> function;
+
+    EXPECT_FALSE(function);
+
+    InplaceFunction<int(int)> null{nullptr};
+
+    EXPECT_FALSE(null);
+}
+
+TEST(InplaceFunctionTest, CallingEmptyTerminates) {
+    InplaceFunction<int(int)> function;
+
+    EXPECT_DEATH(function(1), "");
+}
+
+TEST(InplaceFunctionTest, Inline) {
+    int offset = 3;
+    InplaceFunction<int(int)> function{[offset] (int value) {
+        return value + offset;
+    }};
+
+    ASSERT_TRUE(function);
+    EXPECT_EQ(function(4), 7);
+
+    function = [] (int value) { return value * 2; };
+    EXPECT_EQ(function(4), 8);
+
+    function = nullptr;
+    EXPECT_FALSE(function);
+}
+
+TEST(InplaceFunctionTest, NoexceptSignature) {
+    InplaceFunction<int(int) noexcept> function{
+        [] (int value) noexcept { return -value; }};
+
+    static_assert(noexcept(function(1)), "Call must be noexcept");
+    EXPECT_EQ(function(5), -5);
+}
+
+TEST(InplaceFunctionTest, SmallCallableWithAllocatorStaysInline) {
+    CountingAllocator allocator{};
+    InplaceFunction<int(int)> function{allocator,
+        [] (int value) { return value + 1; }};
+
+    EXPECT_EQ(allocator.live, 0u);
+    EXPECT_EQ(function(1), 2);
+}
+
+TEST(InplaceFunctionTest, Remote) {
+    CountingAllocator allocator{};
+
+    {
+        InplaceFunction<int(int)> function{allocator, Large{{1, 0, 0, 0,
+            0, 0, 0, 2}}};
+
+        ASSERT_TRUE(function);
+        EXPECT_EQ(allocator.live, 1u);
+        EXPECT_EQ(function(10), 13);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(InplaceFunctionTest, RemoteAllocationFailure) {
+    CountingAllocator allocator{};
+
+    allocator.fail = true;
+
+    InplaceFunction<int(int)> function{allocator, Large{}};
+
+    EXPECT_FALSE(function);
+}
+
+TEST(InplaceFunctionTest, CopyAndMove) {
+    CountingAllocator allocator{};
+    InplaceFunction<int(int)> local{[] (int value) { return value + 1; }};
+    InplaceFunction<int(int)> remote{allocator, Large{{1, 0, 0, 0,
+        0, 0, 0, 1}}};
+
+    auto local_copy = local;
+    auto remote_copy = remote;
+
+    EXPECT_EQ(local_copy(1), 2);
+    EXPECT_EQ(remote_copy(1), 3);
+    EXPECT_EQ(allocator.live, 2u);
+
+    /* Moving remote callable only moves the pointer */
+    auto moved = std::move(remote);
+
+    EXPECT_FALSE(remote);
+    EXPECT_EQ(moved(1), 3);
+    EXPECT_EQ(allocator.live, 2u);
+
+    local_copy = moved;
+    EXPECT_EQ(local_copy(2), 4);
+    EXPECT_EQ(allocator.live, 3u);
+
+    local_copy = std::move(local);
+    EXPECT_FALSE(local);
+    EXPECT_EQ(local_copy(2), 3);
+    EXPECT_EQ(allocator.live, 2u);
+}
+
+TEST(InplaceFunctionTest, AssignReportsAllocationFailure) {
+    CountingAllocator allocator{};
+    InplaceFunction<int(int)> remote{allocator, Large{{1, 0, 0, 0,
+        0, 0, 0, 1}}};
+    InplaceFunction<int(int)> target{[] (int value) { return value; }};
+
+    allocator.fail = true;
+
+    EXPECT_FALSE(target.assign(remote));
+    EXPECT_EQ(target(5), 5);
+
+    allocator.fail = false;
+
+    EXPECT_TRUE(target.assign(remote));
+    EXPECT_EQ(target(5), 7);
+    EXPECT_EQ(allocator.live, 2u);
+}
+
+TEST(InplaceFunctionTest, CopyTerminatesOnAllocationFailure) {
+    CountingAllocator allocator{};
+    InplaceFunction<int(int)> remote{allocator, Large{}};
+
+    allocator.fail = true;
+
+    EXPECT_DEATH({ auto copy = remote; static_cast<void>(copy); }, "");
+}
+
+TEST(InplaceFunctionTest, MoveOnly) {
+    auto value = std::make_unique<int>(42);
+    InplaceMoveFunction<int()> function{[value = std::move(value)] {
+        return *value;
+    }};
+
+    auto moved = std::move(function);
+
+    EXPECT_FALSE(function);
+    EXPECT_EQ(moved(), 42);
+}
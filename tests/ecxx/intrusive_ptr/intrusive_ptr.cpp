@@ -0,0 +1,143 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/intrusive_ptr.hpp"
+#include "counting_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+using ecxx::RefCounted;
+using ecxx::IntrusivePtr;
+using ecxx::tests::CountingAllocator;
+
+namespace {
+
+struct Node : RefCounted<> {
+    explicit Node(int init) noexcept : value{init} { }
+
+    Node(const Node& other) noexcept = default;
+
+    Node& operator=(const Node& other) noexcept = default;
+
+    ~Node() noexcept { ++destroyed; }
+
+    int value;
+
+    static inline int destroyed{0};
+};
+
+} /* namespace */
+
+TEST(IntrusivePtrTest, AllocateIntrusive) {
+    CountingAllocator allocator{};
+
+    Node::destroyed = 0;
+
+    {
+        auto a = ecxx::allocate_intrusive<Node>(allocator, 3);
+
+        ASSERT_TRUE(a);
+        EXPECT_EQ(a->use_count(), 1u);
+        EXPECT_EQ(a->allocator(), &allocator);
+
+        /* Pointer can be recreated from raw pointer */
+        IntrusivePtr<Node> b{a.get()};
+
+        EXPECT_EQ(a->use_count(), 2u);
+
+        auto c = std::move(b);
+
+        EXPECT_FALSE(b);
+        EXPECT_EQ(a->use_count(), 2u);
+    }
+
+    EXPECT_EQ(Node::destroyed, 1);
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(IntrusivePtrTest, DetachAndAdopt) {
+    CountingAllocator allocator{};
+    auto a = ecxx::allocate_intrusive<Node>(allocator, 1);
+    auto raw = a.detach();
+
+    EXPECT_FALSE(a);
+    EXPECT_EQ(raw->use_count(), 1u);
+
+    IntrusivePtr<Node> adopted{raw, false};
+
+    EXPECT_EQ(adopted->use_count(), 1u);
+
+    adopted.reset();
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(IntrusivePtrTest, CopyAndAssign) {
+    CountingAllocator allocator{};
+    auto a = ecxx::allocate_intrusive<Node>(allocator, 1);
+    auto b = ecxx::allocate_intrusive<Node>(allocator, 2);
+    auto c = a;
+
+    EXPECT_EQ(a->use_count(), 2u);
+
+    c = b;
+    EXPECT_EQ(a->use_count(), 1u);
+    EXPECT_EQ(b->use_count(), 2u);
+
+    b = nullptr;
+    EXPECT_EQ(c->value, 2);
+    EXPECT_EQ(allocator.live, 2u);
+
+    c.reset();
+    EXPECT_EQ(allocator.live, 1u);
+}
+
+TEST(IntrusivePtrTest, ObjectWithoutAllocatorIsNotDestroyed) {
+    Node::destroyed = 0;
+
+    Node node{5};
+
+    {
+        IntrusivePtr<Node> ptr{&node};
+
+        EXPECT_EQ(node.use_count(), 2u);
+    }
+
+    EXPECT_EQ(node.use_count(), 1u);
+    EXPECT_EQ(Node::destroyed, 0);
+}
+
+TEST(IntrusivePtrTest, CopiedObjectHasOwnCount) {
+    CountingAllocator allocator{};
+    auto a = ecxx::allocate_intrusive<Node>(allocator, 1);
+    IntrusivePtr<Node> b{a};
+    auto raw = a.get();
+
+    ASSERT_NE(raw, nullptr);
+
+    Node copy{*raw};
+
+    EXPECT_EQ(copy.use_count(), 1u);
+    EXPECT_EQ(copy.allocator(), nullptr);
+    EXPECT_EQ(raw->use_count(), 2u);
+}
+
+TEST(IntrusivePtrTest, AllocationFailure) {
+    CountingAllocator allocator{};
+
+    allocator.fail = true;
+
+    EXPECT_FALSE(ecxx::allocate_intrusive<Node>(allocator, 1));
+}
@@ -0,0 +1,181 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/io.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using ecxx::io::ConstBuffer;
+using ecxx::io::MutableBuffer;
+using ecxx::io::MAX_FRAGMENTS;
+
+namespace {
+
+class IoTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(::pipe(m_pipe), 0);
+    }
+
+    void TearDown() override {
+        ::close(m_pipe[0]);
+        ::close(m_pipe[1]);
+    }
+
+    auto drain() noexcept -> std::size_t {
+        std::uint8_t buffer[4096];
+        std::size_t total = 0;
+        ssize_t n = 0;
+
+        while ((n = ::read(m_pipe[0], buffer, sizeof(buffer))) > 0) {
+            total += std::size_t(n);
+        }
+
+        return total;
+    }
+
+    int m_pipe[2]{-1, -1};
+};
+
+auto total_size(const ecxx::Span<ConstBuffer>& fragments) noexcept
+        -> std::size_t {
+    std::size_t total = 0;
+
+    for (const auto& fragment : fragments) {
+        total += fragment.size();
+    }
+
+    return total;
+}
+
+} /* namespace */
+
+TEST_F(IoTest, EmptyFragmentsDoNotCount) {
+    const std::uint8_t byte{'x'};
+    std::vector<ConstBuffer> fragments;
+
+    for (std::size_t i = 0; i < MAX_FRAGMENTS; ++i) {
+        fragments.push_back(ConstBuffer{&byte, 1u});
+        fragments.push_back(ConstBuffer{});
+    }
+
+    EXPECT_EQ(ecxx::io::write(m_pipe[1], fragments),
+            std::ptrdiff_t(MAX_FRAGMENTS));
+
+    std::vector<std::uint8_t> data(MAX_FRAGMENTS);
+    std::vector<MutableBuffer> in;
+
+    for (auto& value : data) {
+        in.push_back(MutableBuffer{&value, 1u});
+    }
+
+    EXPECT_EQ(ecxx::io::read(m_pipe[0], in), std::ptrdiff_t(MAX_FRAGMENTS));
+    EXPECT_EQ(data.back(), 'x');
+}
+
+TEST_F(IoTest, TooManyFragmentsAreRejected) {
+    std::uint8_t byte{'x'};
+    std::vector<ConstBuffer> out(MAX_FRAGMENTS + 1u, ConstBuffer{&byte, 1u});
+    std::vector<MutableBuffer> in(MAX_FRAGMENTS + 1u,
+            MutableBuffer{&byte, 1u});
+
+    EXPECT_EQ(ecxx::io::write(m_pipe[1], out), -EMSGSIZE);
+    EXPECT_EQ(ecxx::io::read(m_pipe[0], in), -EMSGSIZE);
+
+    int sockets[2]{-1, -1};
+
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets), 0);
+
+    /* Datagram is never sent truncated */
+    EXPECT_EQ(ecxx::io::send(sockets[0], out), -EMSGSIZE);
+    EXPECT_EQ(ecxx::io::send(sockets[0], ecxx::Span<ConstBuffer>{out}.first(
+        MAX_FRAGMENTS)), std::ptrdiff_t(MAX_FRAGMENTS));
+    EXPECT_EQ(ecxx::io::receive(sockets[1], in), -EMSGSIZE);
+    EXPECT_EQ(ecxx::io::receive(sockets[1], ecxx::Span<MutableBuffer>{in}.
+        first(MAX_FRAGMENTS)), std::ptrdiff_t(MAX_FRAGMENTS));
+
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+}
+
+TEST_F(IoTest, WriteAllSplitsLongLists) {
+    const std::uint8_t bytes[]{'a', 'b', 'c'};
+    std::vector<ConstBuffer> storage(3u * MAX_FRAGMENTS, ConstBuffer{bytes});
+    ecxx::Span<ConstBuffer> fragments{storage};
+
+    const auto expected = std::ptrdiff_t(total_size(fragments));
+
+    EXPECT_EQ(ecxx::io::write_all(m_pipe[1], fragments), expected);
+    EXPECT_TRUE(fragments.empty());
+
+    ASSERT_EQ(::fcntl(m_pipe[0], F_SETFL, O_NONBLOCK), 0);
+    EXPECT_EQ(std::ptrdiff_t(drain()), expected);
+}
+
+TEST_F(IoTest, WriteAllKeepsProgressWhenPipeFills) {
+    ASSERT_EQ(::fcntl(m_pipe[0], F_SETFL, O_NONBLOCK), 0);
+    ASSERT_EQ(::fcntl(m_pipe[1], F_SETFL, O_NONBLOCK), 0);
+
+    const auto capacity = ::fcntl(m_pipe[1], F_GETPIPE_SZ);
+
+    ASSERT_GT(capacity, 0);
+
+    /* Fill the pipe up to the last page so only part of fragments fits */
+    constexpr std::size_t PAGE{4096u};
+
+    std::vector<std::uint8_t> filler(std::size_t(capacity) - PAGE, 0u);
+
+    ASSERT_EQ(::write(m_pipe[1], filler.data(), filler.size()),
+            ssize_t(filler.size()));
+
+    std::vector<std::uint8_t> data(3u * PAGE, 'd');
+    ConstBuffer storage[]{
+        ConstBuffer{data.data(), PAGE},
+        ConstBuffer{data.data() + PAGE, PAGE},
+        ConstBuffer{data.data() + (2u * PAGE), PAGE}
+    };
+
+    ecxx::Span<ConstBuffer> fragments{storage};
+
+    const auto written = ecxx::io::write_all(m_pipe[1], fragments);
+
+    ASSERT_GT(written, 0);
+    ASSERT_LT(written, std::ptrdiff_t(data.size()));
+    EXPECT_EQ(total_size(fragments), data.size() - std::size_t(written));
+
+    /* Pipe is still full, the next call reports it */
+    EXPECT_EQ(ecxx::io::write_all(m_pipe[1], fragments), -EAGAIN);
+
+    auto drained = drain();
+
+    while (!fragments.empty()) {
+        const auto n = ecxx::io::write_all(m_pipe[1], fragments);
+
+        ASSERT_TRUE((n > 0) || (n == -EAGAIN));
+        drained += drain();
+    }
+
+    EXPECT_EQ(drained, filler.size() + data.size());
+}
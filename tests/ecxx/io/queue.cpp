@@ -0,0 +1,288 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/io/queue.hpp"
+#include "ecxx/allocator/standard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+using ecxx::io::Queue;
+using ecxx::io::ConstBuffer;
+using ecxx::io::MutableBuffer;
+
+namespace {
+
+/* Queue without io_uring, operations run synchronously in submit() */
+class QueueFallbackTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(::pipe(m_pipe), 0);
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, m_sockets), 0);
+    }
+
+    void TearDown() override {
+        for (auto fd : {m_pipe[0], m_pipe[1], m_sockets[0], m_sockets[1]}) {
+            ::close(fd);
+        }
+    }
+
+    ecxx::allocator::Standard m_allocator{};
+    Queue m_queue{m_allocator, 4u, false};
+    int m_pipe[2]{-1, -1};
+    int m_sockets[2]{-1, -1};
+};
+
+} /* namespace */
+
+TEST_F(QueueFallbackTest, Synchronous) {
+    EXPECT_FALSE(m_queue.asynchronous());
+    EXPECT_EQ(m_queue.capacity(), 4u);
+    EXPECT_EQ(m_queue.pending(), 0u);
+}
+
+TEST_F(QueueFallbackTest, WriteThenRead) {
+    const std::uint8_t hello[]{'h', 'e', 'l', 'l', 'o'};
+    const std::uint8_t world[]{'w', 'o', 'r', 'l', 'd'};
+    ConstBuffer out[]{ConstBuffer{hello}, ConstBuffer{}, ConstBuffer{world}};
+
+    ASSERT_TRUE(m_queue.write(m_pipe[1], out, 1u));
+    EXPECT_EQ(m_queue.pending(), 1u);
+
+    std::uint8_t first[3]{};
+    std::uint8_t second[7]{};
+    MutableBuffer in[]{MutableBuffer{first}, MutableBuffer{second}};
+
+    ASSERT_TRUE(m_queue.read(m_pipe[0], in, 2u));
+    EXPECT_EQ(m_queue.pending(), 2u);
+
+    /* Operations run in order they were queued */
+    EXPECT_EQ(m_queue.submit(), 2);
+
+    Queue::Completion completions[4]{};
+
+    ASSERT_EQ(m_queue.complete(completions, 2u), 2);
+    EXPECT_EQ(m_queue.pending(), 0u);
+    EXPECT_EQ(completions[0].data, 1u);
+    EXPECT_EQ(completions[0].result, 10);
+    EXPECT_EQ(completions[1].data, 2u);
+    EXPECT_EQ(completions[1].result, 10);
+    EXPECT_EQ(std::memcmp(first, "hel", 3), 0);
+    EXPECT_EQ(std::memcmp(second, "loworld", 7), 0);
+}
+
+TEST_F(QueueFallbackTest, SendThenReceive) {
+    const std::uint8_t message[]{'p', 'i', 'n', 'g'};
+    ConstBuffer out[]{ConstBuffer{message}};
+
+    std::uint8_t buffer[8]{};
+    MutableBuffer in[]{MutableBuffer{buffer}};
+
+    ASSERT_TRUE(m_queue.send(m_sockets[0], out, 7u));
+    ASSERT_TRUE(m_queue.receive(m_sockets[1], in, 8u));
+
+    Queue::Completion completions[2]{};
+
+    ASSERT_EQ(m_queue.complete(completions), 2);
+    EXPECT_EQ(completions[0].data, 7u);
+    EXPECT_EQ(completions[0].result, 4);
+    EXPECT_EQ(completions[1].data, 8u);
+    EXPECT_EQ(completions[1].result, 4);
+    EXPECT_EQ(std::memcmp(buffer, "ping", 4), 0);
+}
+
+TEST_F(QueueFallbackTest, ErrorsAreReportedInCompletion) {
+    std::uint8_t buffer[4]{};
+    MutableBuffer in[]{MutableBuffer{buffer}};
+
+    ASSERT_TRUE(m_queue.read(-1, in, 3u));
+
+    Queue::Completion completion{};
+
+    ASSERT_EQ(m_queue.complete({&completion, 1u}), 1);
+    EXPECT_EQ(completion.data, 3u);
+    EXPECT_EQ(completion.result, -EBADF);
+}
+
+TEST_F(QueueFallbackTest, FullQueueRejects) {
+    const std::uint8_t byte[]{0};
+    ConstBuffer out[]{ConstBuffer{byte}};
+
+    for (std::uint64_t i = 0; i < m_queue.capacity(); ++i) {
+        ASSERT_TRUE(m_queue.write(m_pipe[1], out, i));
+    }
+
+    EXPECT_FALSE(m_queue.write(m_pipe[1], out, 99u));
+
+    /* Completions are reaped in parts, each frees a slot */
+    Queue::Completion completions[3]{};
+
+    ASSERT_EQ(m_queue.complete(completions), 3);
+    EXPECT_EQ(m_queue.pending(), 1u);
+    EXPECT_EQ(completions[2].data, 2u);
+    EXPECT_TRUE(m_queue.write(m_pipe[1], out, 4u));
+
+    ASSERT_EQ(m_queue.complete(completions), 2);
+    EXPECT_EQ(completions[0].data, 3u);
+    EXPECT_EQ(completions[1].data, 4u);
+    EXPECT_EQ(m_queue.pending(), 0u);
+}
+
+TEST_F(QueueFallbackTest, TooManyFragmentsAreRejected) {
+    const std::uint8_t byte{0};
+    std::vector<ConstBuffer> fragments(std::size_t(IOV_MAX) + 1u,
+            ConstBuffer{&byte, 1u});
+
+    EXPECT_FALSE(m_queue.write(m_pipe[1], fragments, 1u));
+    EXPECT_EQ(m_queue.pending(), 0u);
+
+    /* Empty fragments do not count toward the limit */
+    fragments.back() = ConstBuffer{};
+
+    EXPECT_TRUE(m_queue.write(m_pipe[1], fragments, 2u));
+
+    Queue::Completion completion{};
+
+    ASSERT_EQ(m_queue.complete({&completion, 1u}), 1);
+    EXPECT_EQ(completion.data, 2u);
+    EXPECT_EQ(completion.result, IOV_MAX);
+}
+
+TEST_F(QueueFallbackTest, FragmentListMayGoAwayAfterQueueing) {
+    const std::uint8_t data[]{'a', 'b'};
+    {
+        ConstBuffer out[]{ConstBuffer{data}};
+
+        ASSERT_TRUE(m_queue.write(m_pipe[1], out, 1u));
+        out[0] = ConstBuffer{};
+    }
+
+    Queue::Completion completion{};
+
+    ASSERT_EQ(m_queue.complete({&completion, 1u}), 1);
+    EXPECT_EQ(completion.result, 2);
+}
+
+TEST_F(QueueFallbackTest, DestructorCompletesPending) {
+    const std::uint8_t data[]{'x'};
+    ConstBuffer out[]{ConstBuffer{data}};
+
+    {
+        Queue queue{m_allocator, 2u, false};
+
+        ASSERT_TRUE(queue.write(m_pipe[1], out, 1u));
+        ASSERT_TRUE(queue.write(m_pipe[1], out, 2u));
+    }
+
+    std::uint8_t buffer[4]{};
+
+    EXPECT_EQ(::read(m_pipe[0], buffer, sizeof(buffer)), 2);
+}
+
+TEST(QueueTest, AsynchronousMatchesFallback) {
+    ecxx::allocator::Standard allocator{};
+    Queue queue{allocator, 8u};
+
+    if (!queue.asynchronous()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    int fds[2]{-1, -1};
+
+    ASSERT_EQ(::pipe(fds), 0);
+
+    const std::uint8_t data[]{'a', 'b', 'c'};
+    ConstBuffer out[]{ConstBuffer{data}};
+
+    ASSERT_TRUE(queue.write(fds[1], out, 5u));
+
+    Queue::Completion completion{};
+
+    ASSERT_EQ(queue.complete({&completion, 1u}, 1u), 1);
+    EXPECT_EQ(completion.data, 5u);
+    EXPECT_EQ(completion.result, 3);
+    EXPECT_EQ(queue.pending(), 0u);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(QueueTest, DestructorCancelsOperationsWaitingForPeer) {
+    ecxx::allocator::Standard allocator{};
+    int sockets[2]{-1, -1};
+
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+    std::uint8_t buffer[8]{};
+    MutableBuffer in[]{MutableBuffer{buffer}};
+
+    {
+        Queue queue{allocator, 4u};
+
+        if (!queue.asynchronous()) {
+            ::close(sockets[0]);
+            ::close(sockets[1]);
+            GTEST_SKIP() << "io_uring is not available";
+        }
+
+        /* Peer never sends, destructor must not wait for it */
+        ASSERT_TRUE(queue.receive(sockets[0], in, 1u));
+        ASSERT_TRUE(queue.read(sockets[0], in, 2u));
+        ASSERT_EQ(queue.submit(), 2);
+    }
+
+    ::close(sockets[0]);
+    ::close(sockets[1]);
+}
+
+TEST(QueueTest, CompletionsAfterManyInFlight) {
+    ecxx::allocator::Standard allocator{};
+    Queue queue{allocator, 8u};
+    int fds[2]{-1, -1};
+
+    ASSERT_EQ(::pipe(fds), 0);
+
+    const std::uint8_t data[]{'z'};
+    ConstBuffer out[]{ConstBuffer{data}};
+
+    for (std::uint64_t i = 0; i < 8u; ++i) {
+        ASSERT_TRUE(queue.write(fds[1], out, i));
+    }
+
+    Queue::Completion completions[8]{};
+    std::size_t reaped = 0;
+
+    while (reaped < 8u) {
+        const auto n = queue.complete({completions + reaped, 8u - reaped}, 1u);
+
+        ASSERT_GT(n, 0);
+        reaped += std::size_t(n);
+    }
+
+    EXPECT_EQ(queue.pending(), 0u);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
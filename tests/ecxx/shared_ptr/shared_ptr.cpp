@@ -0,0 +1,166 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/shared_ptr.hpp"
+#include "counting_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using ecxx::SharedPtr;
+using ecxx::LocalSharedPtr;
+using ecxx::tests::CountingAllocator;
+
+namespace {
+
+struct Pair {
+    Pair(int init_first, int init_second) noexcept :
+        first{init_first}, second{init_second} { }
+
+    Pair(const Pair& other) noexcept = default;
+
+    Pair& operator=(const Pair& other) noexcept = default;
+
+    ~Pair() noexcept { ++destroyed; }
+
+    int first;
+    int second;
+
+    static inline int destroyed{0};
+};
+
+} /* namespace */
+
+TEST(SharedPtrTest, Empty) {
+    SharedPtr<int> ptr;
+
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(ptr.use_count(), 0u);
+}
+
+TEST(SharedPtrTest, CountsAndRelease) {
+    CountingAllocator allocator{};
+
+    Pair::destroyed = 0;
+
+    {
+        auto a = ecxx::allocate_shared<Pair>(allocator, 1, 2);
+
+        ASSERT_TRUE(a);
+        EXPECT_EQ(a.use_count(), 1u);
+        EXPECT_EQ(allocator.live, 1u);
+
+        {
+            auto b = a;
+
+            EXPECT_EQ(a.use_count(), 2u);
+            EXPECT_EQ(b.get(), a.get());
+
+            SharedPtr<Pair> c;
+
+            c = b;
+            EXPECT_EQ(a.use_count(), 3u);
+
+            auto d = std::move(c);
+
+            EXPECT_FALSE(c);
+            EXPECT_EQ(a.use_count(), 3u);
+        }
+
+        EXPECT_EQ(a.use_count(), 1u);
+        EXPECT_EQ(Pair::destroyed, 0);
+    }
+
+    /* Object and its control block go back to allocator together */
+    EXPECT_EQ(Pair::destroyed, 1);
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SharedPtrTest, Aliasing) {
+    CountingAllocator allocator{};
+    SharedPtr<int> second;
+
+    {
+        auto pair = ecxx::allocate_shared<Pair>(allocator, 1, 2);
+
+        second = SharedPtr<int>{pair, &pair->second};
+        EXPECT_EQ(pair.use_count(), 2u);
+    }
+
+    EXPECT_EQ(*second, 2);
+    EXPECT_EQ(second.use_count(), 1u);
+    EXPECT_EQ(allocator.live, 1u);
+
+    second.reset();
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SharedPtrTest, AllocationFailure) {
+    CountingAllocator allocator{};
+
+    allocator.fail = true;
+
+    auto ptr = ecxx::allocate_shared<int>(allocator, 1);
+
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(ptr.use_count(), 0u);
+}
+
+TEST(SharedPtrTest, LocalCounter) {
+    CountingAllocator allocator{};
+
+    {
+        auto a = ecxx::allocate_local_shared<int>(allocator, 4);
+        LocalSharedPtr<int> b{a};
+
+        EXPECT_EQ(b.use_count(), 2u);
+        EXPECT_EQ(*b, 4);
+
+        a.swap(b);
+        a = nullptr;
+        EXPECT_EQ(b.use_count(), 1u);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SharedPtrTest, CopiesAcrossThreads) {
+    CountingAllocator allocator{};
+
+    {
+        auto ptr = ecxx::allocate_shared<int>(allocator, 9);
+        std::vector<std::thread> threads;
+
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([ptr] () noexcept {
+                for (int j = 0; j < 1000; ++j) {
+                    auto copy = ptr;
+                    static_cast<void>(copy);
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        EXPECT_EQ(ptr.use_count(), 1u);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
@@ -0,0 +1,381 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/sort.hpp"
+#include "ecxx/executor.hpp"
+#include "counting_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using ecxx::Span;
+using ecxx::Executor;
+using ecxx::tests::CountingAllocator;
+
+namespace {
+
+struct Record {
+    std::uint16_t key;
+    std::uint32_t index;
+};
+
+struct ByKey {
+    auto operator()(const Record& record) const noexcept -> std::uint16_t {
+        return record.key;
+    }
+};
+
+/* Few distinct keys, so equal keys are common and order among them shows */
+auto records(std::size_t size, std::uint16_t keys) -> std::vector<Record> {
+    std::mt19937 random{size};
+    std::uniform_int_distribution<std::uint16_t> distribution{0u,
+        std::uint16_t(keys - 1u)};
+    std::vector<Record> result(size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        result[i] = Record{distribution(random), std::uint32_t(i)};
+    }
+
+    return result;
+}
+
+template<typename T>
+auto span(std::vector<T>& values) noexcept -> Span<T> {
+    return Span<T>{values.data(), values.size()};
+}
+
+void expect_stable(const std::vector<Record>& sorted,
+        std::vector<Record> expected) {
+    std::stable_sort(expected.begin(), expected.end(),
+        [] (const Record& lhs, const Record& rhs) noexcept {
+            return lhs.key < rhs.key;
+        });
+
+    ASSERT_EQ(sorted.size(), expected.size());
+
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        ASSERT_EQ(sorted[i].key, expected[i].key) << i;
+        ASSERT_EQ(sorted[i].index, expected[i].index) << i;
+    }
+}
+
+/* Compares bit patterns, so -0.0 and +0.0 are different */
+template<typename T>
+void expect_order(const std::vector<T>& sorted) {
+    for (std::size_t i = 1; i < sorted.size(); ++i) {
+        const auto lhs = sorted[i - 1u];
+        const auto rhs = sorted[i];
+
+        ASSERT_FALSE(rhs < lhs) << i;
+
+        if (!(lhs < rhs)) {
+            ASSERT_GE(std::signbit(lhs), std::signbit(rhs)) << i;
+        }
+    }
+}
+
+} /* namespace */
+
+TEST(SortTest, Empty) {
+    CountingAllocator allocator{};
+    std::vector<std::uint32_t> values;
+
+    ecxx::sort(allocator, span(values));
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SortTest, UnsignedKeys) {
+    CountingAllocator allocator{};
+
+    for (std::size_t size : {2u, 63u, 64u, 65u, 1000u, 4099u}) {
+        std::mt19937 random{size};
+        std::vector<std::uint64_t> values(size);
+
+        for (auto& value : values) {
+            value = random();
+        }
+
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        ecxx::sort(allocator, span(values));
+        EXPECT_EQ(values, expected) << size;
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SortTest, SignedKeys) {
+    CountingAllocator allocator{};
+    std::mt19937 random{7u};
+    std::uniform_int_distribution<std::int32_t> distribution{
+        std::numeric_limits<std::int32_t>::min(),
+        std::numeric_limits<std::int32_t>::max()};
+    std::vector<std::int32_t> values(1000u);
+
+    for (auto& value : values) {
+        value = distribution(random);
+    }
+
+    values[10] = std::numeric_limits<std::int32_t>::min();
+    values[20] = std::numeric_limits<std::int32_t>::max();
+    values[30] = -1;
+    values[40] = 0;
+
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    ecxx::sort(allocator, span(values));
+    EXPECT_EQ(values, expected);
+}
+
+TEST(SortTest, SmallSignedKeys) {
+    CountingAllocator allocator{};
+    std::vector<std::int8_t> values{3, -128, 127, -1, 0, 1, -2, 2};
+
+    ecxx::sort(allocator, span(values));
+    EXPECT_EQ(values, (std::vector<std::int8_t>{-128, -2, -1, 0, 1, 2, 3,
+                127}));
+}
+
+TEST(SortTest, FloatingPointKeys) {
+    CountingAllocator allocator{};
+    constexpr auto INF = std::numeric_limits<double>::infinity();
+
+    /* Both sizes, so insertion sort and radix passes are exercised */
+    for (std::size_t size : {16u, 1000u}) {
+        std::mt19937 random{size};
+        std::uniform_real_distribution<double> distribution{-1e6, 1e6};
+        std::vector<double> values{-0.0, 0.0, INF, -INF, -0.0,
+            std::numeric_limits<double>::denorm_min(),
+            -std::numeric_limits<double>::denorm_min()};
+
+        while (values.size() < size) {
+            values.push_back(distribution(random));
+        }
+
+        std::shuffle(values.begin(), values.end(), random);
+
+        ecxx::sort(allocator, span(values));
+        expect_order(values);
+
+        EXPECT_EQ(values.front(), -INF);
+        EXPECT_EQ(values.back(), INF);
+
+        const auto zero = std::find(values.begin(), values.end(), 0.0);
+
+        ASSERT_LE(zero + 3, values.end());
+        EXPECT_TRUE(std::signbit(zero[0]));
+        EXPECT_TRUE(std::signbit(zero[1]));
+        EXPECT_FALSE(std::signbit(zero[2]));
+        EXPECT_EQ(zero[-1], -std::numeric_limits<double>::denorm_min());
+        EXPECT_EQ(zero[3], std::numeric_limits<double>::denorm_min());
+    }
+}
+
+TEST(SortTest, NegativeFloats) {
+    CountingAllocator allocator{};
+    std::vector<float> values(200u);
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = -float(i) * 0.5f;
+    }
+
+    ecxx::sort(allocator, span(values));
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(values[i], -float(values.size() - 1u - i) * 0.5f);
+    }
+}
+
+TEST(SortTest, StableOrder) {
+    CountingAllocator allocator{};
+
+    for (std::size_t size : {50u, 5000u}) {
+        auto values = records(size, 7u);
+        const auto original = values;
+
+        ecxx::sort(allocator, span(values), ByKey{});
+        expect_stable(values, original);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SortTest, SkipsConstantDigits) {
+    CountingAllocator allocator{};
+    auto values = records(1000u, 4u);
+    const auto original = values;
+
+    /* Only the lowest digit differs */
+    for (auto& value : values) {
+        value.key = std::uint16_t(value.key | 0x5500u);
+    }
+
+    ecxx::sort(allocator, span(values), ByKey{});
+
+    auto expected = original;
+
+    for (auto& value : expected) {
+        value.key = std::uint16_t(value.key | 0x5500u);
+    }
+
+    expect_stable(values, expected);
+}
+
+TEST(SortTest, AllocationFailureStillSorts) {
+    CountingAllocator allocator{};
+    auto values = records(1000u, 100u);
+
+    allocator.fail = true;
+    ecxx::sort(allocator, span(values), ByKey{});
+
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end(),
+        [] (const Record& lhs, const Record& rhs) noexcept {
+            return lhs.key < rhs.key;
+        }));
+}
+
+TEST(SortTest, ParallelStableOrder) {
+    CountingAllocator allocator{};
+
+    {
+        Executor executor{allocator, 4u};
+        auto values = records(200000u, 1000u);
+        const auto original = values;
+
+        ecxx::sort(executor, span(values), ByKey{});
+        expect_stable(values, original);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(SortTest, ParallelSignedKeys) {
+    CountingAllocator allocator{};
+    Executor executor{allocator, 4u};
+    std::mt19937 random{11u};
+    std::vector<std::int64_t> values(100000u);
+
+    for (auto& value : values) {
+        value = std::int64_t(random()) - std::int64_t(random());
+    }
+
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    ecxx::sort(executor, span(values));
+    EXPECT_EQ(values, expected);
+}
+
+TEST(PartitionTest, MatchesPredicate) {
+    for (std::size_t size : {0u, 1u, 127u, 128u, 129u, 1000u, 4096u}) {
+        std::mt19937 random{size};
+        std::vector<std::uint32_t> values(size);
+
+        for (auto& value : values) {
+            value = std::uint32_t(random() % 1000u);
+        }
+
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto predicate = [] (std::uint32_t value) noexcept {
+            return value < 300u;
+        };
+
+        const auto count = ecxx::partition(span(values), predicate);
+
+        EXPECT_EQ(count, std::size_t(std::count_if(values.begin(),
+                        values.end(), predicate))) << size;
+        EXPECT_TRUE(std::is_partitioned(values.begin(), values.end(),
+                    predicate)) << size;
+
+        /* Elements are only moved around */
+        std::sort(values.begin(), values.end());
+        EXPECT_EQ(values, sorted) << size;
+    }
+}
+
+TEST(PartitionTest, AllOrNothing) {
+    std::vector<int> values(1000u, 1);
+
+    EXPECT_EQ(ecxx::partition(span(values),
+                [] (int value) noexcept { return value == 1; }), 1000u);
+    EXPECT_EQ(ecxx::partition(span(values),
+                [] (int value) noexcept { return value == 0; }), 0u);
+}
+
+TEST(NthElementTest, MatchesSortedOrder) {
+    for (std::size_t size : {1u, 16u, 17u, 1000u, 10000u}) {
+        std::mt19937 random{size};
+        std::vector<int> values(size);
+
+        for (auto& value : values) {
+            value = int(random() % 100u) - 50;
+        }
+
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (std::size_t n : {std::size_t(0u), size / 3u, size / 2u,
+                size - 1u}) {
+            auto selected = values;
+
+            ecxx::nth_element(span(selected), n);
+            ASSERT_EQ(selected[n], sorted[n]) << size << " " << n;
+
+            for (std::size_t i = 0; i < n; ++i) {
+                ASSERT_LE(selected[i], selected[n]);
+            }
+
+            for (std::size_t i = n + 1u; i < size; ++i) {
+                ASSERT_GE(selected[i], selected[n]);
+            }
+        }
+    }
+}
+
+TEST(NthElementTest, AllEqualAndOutOfRange) {
+    std::vector<int> values(1000u, 5);
+
+    ecxx::nth_element(span(values), 500u);
+    EXPECT_EQ(values[500], 5);
+
+    std::vector<int> unsorted{3, 2, 1};
+
+    ecxx::nth_element(span(unsorted), 3u);
+    EXPECT_EQ(unsorted, (std::vector<int>{3, 2, 1}));
+}
+
+TEST(NthElementTest, CustomCompare) {
+    std::vector<int> values(500u);
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = int(i);
+    }
+
+    std::shuffle(values.begin(), values.end(), std::mt19937{3u});
+    ecxx::nth_element(span(values), 10u, std::greater<>{});
+    EXPECT_EQ(values[10], 489);
+}
@@ -0,0 +1,256 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/trace.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
+
+using ecxx::Span;
+using ecxx::trace::Event;
+using ecxx::trace::Buffer;
+
+namespace {
+
+/* Probes are off by default, tests turn them on only while running */
+class TraceTest : public ::testing::Test {
+protected:
+    void SetUp() override { Buffer::enable(); }
+
+    void TearDown() override { Buffer::enable(false); }
+};
+
+auto dump() -> std::string {
+    std::string output;
+    auto file = std::tmpfile();
+
+    if (file != nullptr) {
+        if (ecxx::trace::dump(file)) {
+            char chunk[256];
+
+            std::rewind(file);
+
+            for (auto n = std::fread(chunk, 1u, sizeof(chunk), file); n != 0;
+                    n = std::fread(chunk, 1u, sizeof(chunk), file)) {
+                output.append(chunk, n);
+            }
+        }
+
+        std::fclose(file);
+    }
+
+    return output;
+}
+
+auto has_payload(const std::string& output, std::uint64_t payload) -> bool {
+    return output.find("\"payload\":" + std::to_string(payload) + "}") !=
+        std::string::npos;
+}
+
+} /* namespace */
+
+TEST_F(TraceTest, CapacityRoundsDown) {
+    Event events[100];
+
+    Buffer buffer{Span<Event>{events, 100u}};
+    EXPECT_EQ(buffer.capacity(), 64u);
+
+    Buffer single{Span<Event>{events, 1u}};
+    EXPECT_EQ(single.capacity(), 1u);
+}
+
+TEST_F(TraceTest, EmptyBufferIsNotAttached) {
+    Event events[4];
+    Buffer buffer{Span<Event>{events, 4u}};
+    Buffer empty{Span<Event>{}};
+
+    EXPECT_EQ(empty.capacity(), 0u);
+    EXPECT_EQ(Buffer::current(), &buffer);
+
+    empty.attach();
+    EXPECT_EQ(Buffer::current(), &buffer);
+}
+
+TEST_F(TraceTest, DisabledProbesDoNotWrite) {
+    Event events[4];
+    Buffer buffer{Span<Event>{events, 4u}};
+
+    Buffer::enable(false);
+    EXPECT_EQ(Buffer::current(), nullptr);
+
+    ecxx::trace::instant("off");
+    EXPECT_EQ(buffer.written(), 0u);
+
+    Buffer::enable();
+    ecxx::trace::instant("on");
+    EXPECT_EQ(buffer.written(), 1u);
+}
+
+TEST_F(TraceTest, RingWrapAround) {
+    Event events[8];
+    Buffer buffer{Span<Event>{events, 8u}};
+
+    for (std::uint64_t i = 0; i < 20u; ++i) {
+        ecxx::trace::instant("tick", 100u + i);
+    }
+
+    EXPECT_EQ(buffer.written(), 20u);
+
+    /*
+     * Newest events are dumped oldest first. Slot of the oldest one is the
+     * next to be written, so dump skips it as possibly torn
+     */
+    const auto output = dump();
+    std::size_t position = 0;
+
+    for (std::uint64_t i = 0; i < 13u; ++i) {
+        EXPECT_FALSE(has_payload(output, 100u + i)) << i;
+    }
+
+    for (std::uint64_t i = 13u; i < 20u; ++i) {
+        const auto found = output.find("\"payload\":" +
+                std::to_string(100u + i) + "}", position);
+
+        ASSERT_NE(found, std::string::npos) << i;
+        position = found;
+    }
+}
+
+TEST_F(TraceTest, RingBeforeWrapAround) {
+    Event events[8];
+    Buffer buffer{Span<Event>{events, 8u}};
+
+    for (std::uint64_t i = 0; i < 7u; ++i) {
+        ecxx::trace::instant("tick", 200u + i);
+    }
+
+    const auto output = dump();
+
+    for (std::uint64_t i = 0; i < 7u; ++i) {
+        EXPECT_TRUE(has_payload(output, 200u + i)) << i;
+    }
+}
+
+TEST_F(TraceTest, DumpJson) {
+    Event events[8];
+    Buffer buffer{Span<Event>{events, 8u}, "worker \"1\""};
+
+    ecxx::trace::instant("instant", 7u);
+
+    {
+        ecxx::trace::Scope scope{"scope", 9u};
+    }
+
+    const auto output = dump();
+
+    EXPECT_EQ(output.rfind("{\"traceEvents\":[", 0u), 0u);
+    EXPECT_EQ(output.substr(output.size() - 4u), "\n]}\n");
+    EXPECT_NE(output.find("\"args\":{\"name\":\"worker \\\"1\\\"\"}}"),
+            std::string::npos);
+    EXPECT_NE(output.find("{\"name\":\"instant\",\"ph\":\"i\",\"s\":\"t\""),
+            std::string::npos);
+    EXPECT_NE(output.find("{\"name\":\"scope\",\"ph\":\"X\""),
+            std::string::npos);
+    EXPECT_NE(output.find("\"dur\":"), std::string::npos);
+    EXPECT_TRUE(has_payload(output, 7u));
+    EXPECT_TRUE(has_payload(output, 9u));
+}
+
+TEST_F(TraceTest, DestroyedBufferIsNotDumped) {
+    {
+        Event events[4];
+        Buffer buffer{Span<Event>{events, 4u}};
+
+        ecxx::trace::instant("gone", 12345u);
+    }
+
+    EXPECT_EQ(Buffer::current(), nullptr);
+    EXPECT_FALSE(has_payload(dump(), 12345u));
+}
+
+TEST_F(TraceTest, AttachMovesBuffer) {
+    Event a_events[4];
+    Event b_events[4];
+    Buffer a{Span<Event>{a_events, 4u}};
+
+    {
+        Buffer b{Span<Event>{b_events, 4u}};
+
+        EXPECT_EQ(Buffer::current(), &b);
+
+        a.attach();
+        EXPECT_EQ(Buffer::current(), &a);
+    }
+
+    /* Destroyed buffer was no longer bound, current one stays */
+    EXPECT_EQ(Buffer::current(), &a);
+}
+
+TEST_F(TraceTest, DestroyedOnOtherThread) {
+    Event events[4];
+    std::optional<Buffer> buffer;
+    std::atomic<int> step{0};
+    bool attached = false;
+    bool detached = false;
+
+    std::thread thread{[&] () noexcept {
+        buffer.emplace(Span<Event>{events, 4u});
+        attached = (Buffer::current() == &*buffer);
+        step.store(1);
+
+        while (step.load() != 2) {
+            std::this_thread::yield();
+        }
+
+        detached = (Buffer::current() == nullptr);
+        ecxx::trace::instant("late");
+    }};
+
+    while (step.load() != 1) {
+        std::this_thread::yield();
+    }
+
+    buffer.reset();
+    step.store(2);
+    thread.join();
+
+    EXPECT_TRUE(attached);
+    EXPECT_TRUE(detached);
+}
+
+TEST_F(TraceTest, OwningThreadExits) {
+    Event events[4];
+    std::optional<Buffer> buffer;
+
+    std::thread thread{[&] () noexcept {
+        buffer.emplace(Span<Event>{events, 4u});
+        ecxx::trace::instant("exit", 77u);
+    }};
+
+    thread.join();
+
+    EXPECT_EQ(buffer->written(), 1u);
+    EXPECT_TRUE(has_payload(dump(), 77u));
+
+    buffer.reset();
+}
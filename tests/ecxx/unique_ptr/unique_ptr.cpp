@@ -0,0 +1,165 @@
+/* Copyright 2018 Tymoteusz Blazejczyk
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ecxx/unique_ptr.hpp"
+#include "counting_allocator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <type_traits>
+
+using ecxx::UniquePtr;
+using ecxx::AllocatorDelete;
+using ecxx::tests::CountingAllocator;
+
+namespace {
+
+struct Base {
+    Base() noexcept = default;
+
+    Base(const Base& other) noexcept = default;
+
+    Base& operator=(const Base& other) noexcept = default;
+
+    virtual ~Base() noexcept { ++destroyed; }
+
+    static inline int destroyed{0};
+};
+
+struct Derived final : Base {
+    explicit Derived(int init) noexcept : value{init} { }
+
+    int value;
+};
+
+struct Counted {
+    static inline int deleted{0};
+};
+
+/* Stateless deleter, object is not owned by any allocator */
+struct Forget {
+    void operator()(Counted*) const noexcept { ++Counted::deleted; }
+};
+
+} /* namespace */
+
+static_assert(!std::is_constructible<UniquePtr<int>, int*>::value,
+        "Default deleter without allocator would leak");
+
+static_assert(std::is_constructible<UniquePtr<Counted, Forget>,
+        Counted*>::value, "Stateless deleter needs no allocator");
+
+static_assert(sizeof(UniquePtr<Counted, Forget>) == sizeof(Counted*),
+        "Stateless deleter takes no space");
+
+TEST(UniquePtrTest, AllocateUnique) {
+    CountingAllocator allocator{};
+
+    {
+        auto ptr = ecxx::allocate_unique<int>(allocator, 7);
+
+        ASSERT_TRUE(ptr);
+        EXPECT_EQ(*ptr, 7);
+        EXPECT_EQ(ptr.get_deleter().allocator(), &allocator);
+        EXPECT_EQ(allocator.live, 1u);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(UniquePtrTest, AllocationFailure) {
+    CountingAllocator allocator{};
+
+    allocator.fail = true;
+
+    auto ptr = ecxx::allocate_unique<int>(allocator, 7);
+
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(ptr, nullptr);
+}
+
+TEST(UniquePtrTest, PointerWithAllocator) {
+    CountingAllocator allocator{};
+
+    {
+        UniquePtr<int> ptr{allocator.construct<int>(3), allocator};
+
+        EXPECT_EQ(*ptr, 3);
+    }
+
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(UniquePtrTest, MoveAndConvert) {
+    CountingAllocator allocator{};
+
+    Base::destroyed = 0;
+
+    {
+        auto derived = ecxx::allocate_unique<Derived>(allocator, 5);
+        auto raw = derived.get();
+
+        UniquePtr<Base> base{std::move(derived)};
+
+        EXPECT_FALSE(derived);
+        EXPECT_EQ(base.get(), raw);
+
+        UniquePtr<Base> other;
+
+        other = std::move(base);
+        EXPECT_FALSE(base);
+        EXPECT_EQ(static_cast<Derived*>(other.get())->value, 5);
+    }
+
+    EXPECT_EQ(Base::destroyed, 1);
+    EXPECT_EQ(allocator.live, 0u);
+}
+
+TEST(UniquePtrTest, ReleaseResetSwap) {
+    CountingAllocator allocator{};
+    auto a = ecxx::allocate_unique<int>(allocator, 1);
+    auto b = ecxx::allocate_unique<int>(allocator, 2);
+
+    a.swap(b);
+    EXPECT_EQ(*a, 2);
+    EXPECT_EQ(*b, 1);
+
+    auto raw = a.release();
+
+    EXPECT_FALSE(a);
+    EXPECT_EQ(allocator.live, 2u);
+    allocator.destroy(raw);
+
+    b.reset();
+    EXPECT_EQ(allocator.live, 0u);
+
+    b = nullptr;
+    EXPECT_FALSE(b);
+}
+
+TEST(UniquePtrTest, StatelessDeleter) {
+    Counted object;
+
+    Counted::deleted = 0;
+
+    {
+        UniquePtr<Counted, Forget> ptr{&object};
+
+        EXPECT_EQ(ptr.get(), &object);
+    }
+
+    EXPECT_EQ(Counted::deleted, 1);
+}